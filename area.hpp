@@ -0,0 +1,346 @@
+#ifndef AREA_H
+#define AREA_H
+
+#include <glm/glm.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "shape.hpp"
+#include "zobrist.hpp"
+
+
+#ifndef AREA_WIDTH
+#define AREA_WIDTH 7
+#endif
+#ifndef AREA_HEIGHT
+#define AREA_HEIGHT 12
+#endif
+
+// Occupancy of a single W x W layer, bit (x * W + z) is set for an occupied cell
+template <int W>
+struct LayerMask
+{
+    static const int WORDS = (W * W + 63) / 64;
+    uint64_t words[WORDS] = { 0 };
+
+    bool test(int bit) const { return (words[bit / 64] >> (bit % 64)) & 1; }
+    void set(int bit) { words[bit / 64] |= 1ull << (bit % 64); }
+
+    // OR a run of bits starting at bit (may span two words)
+    void setRun(int bit, uint64_t run)
+    {
+        words[bit / 64] |= run << (bit % 64);
+        if constexpr (WORDS > 1)
+            if (bit % 64 != 0 && bit / 64 + 1 < WORDS)
+                words[bit / 64 + 1] |= run >> (64 - bit % 64);
+    }
+
+    bool intersects(const LayerMask &other) const
+    {
+        uint64_t common = 0;
+        for (int w = 0; w < WORDS; w++)
+            common |= words[w] & other.words[w];
+        return common != 0;
+    }
+};
+
+template <int W, int H>
+class BasicArea
+{
+    public:
+        static const int WIDTH = W;
+        static const int HEIGHT = H;
+        static_assert(W >= SHAPE_WIDTH && W < 64, "Area rows must fit in a 64-bit word");
+        static_assert(H < 256, "Column heights are stored as bytes");
+
+        // Only what collision and evaluation read, materials are kept in their own plane (see materials)
+        struct Layer
+        {
+            LayerMask<W> occupancy;
+            int count = 0; // number of occupied cells
+            uint64_t hash = 0; // XOR of getCellKey() of occupied cells
+        };
+
+        unsigned char heights[W * W] = { 0 }; // per column, y-index above its highest block (0 if empty)
+
+        BasicArea() { for (int j = 0; j < H; j++) layerSlots[j] = j; }
+
+
+        glm::vec3 getCenter() { return glm::vec3(W / 2.0f - 0.5f, H / 2.0f - 0.5f, W / 2.0f - 0.5f); }
+
+        static int getCellBit(int x, int z) { return x * W + z; }
+        const Layer &getLayer(int y) const { return layers[layerSlots[y]]; }
+        const LayerMask<W> &getOccupancy(int y) const { return getLayer(y).occupancy; }
+        int getRowCount(int y) const { return getLayer(y).count; }
+        bool isOccupied(int x, int y, int z) const { return getLayer(y).occupancy.test(getCellBit(x, z)); }
+        int getMaterial(int x, int y, int z) const { return getLayerMaterials(y)[getCellBit(x, z)]; }
+        const unsigned char *getLayerMaterials(int y) const { return materials[layerSlots[y]]; } // indexed by getCellBit()
+        int getColumnHeight(int x, int z) const { return heights[getCellBit(x, z)]; }
+        uint64_t getHash() const { return hash; } // Zobrist hash of the occupancy (materials are ignored)
+        void addBlock(int x, int y, int z, int material);
+        void addShape(const Shape &, glm::ivec3 offset, int material);
+        int clearFullLayers();
+        void rebuildHeights();
+
+        static LayerMask<W> getLayerMask(unsigned int shapeBits, int x, int z);
+        bool overlaps(const Shape &, glm::ivec3 offset) const;
+        bool collides(const Shape &, glm::ivec3 offset) const;
+        int getDropDistance(const Shape &, glm::ivec3 offset) const;
+
+        // Shape resting at offset would stick out of the top, i.e. locking it ends the game
+        static bool isAboveTop(const Shape &shape, glm::ivec3 offset) { return offset.y + shape.boundsMax.y >= H; }
+
+    private:
+        static const uint64_t ROW_MASK = (1ull << W) - 1;
+
+        // Layers are addressed through layerSlots (y-index -> storage slot), so clearing layers only reorders slots
+        Layer layers[H];
+        int layerSlots[H];
+        unsigned char materials[H][W * W] = { }; // material index per cell (0 if empty), by slot like layers
+
+        uint64_t hash = 0; // XOR of getLayerKey() of all layers, kept up to date by addBlock() and clearFullLayers()
+};
+
+typedef BasicArea<AREA_WIDTH, AREA_HEIGHT> Area;
+
+// Occupancy of an Area after locking a Shape and clearing full layers, without copying the Area: only the layers
+// the Shape touches are stored, all others are read from the Area, which has to outlive the view.
+// Lets searches score placements without copying the board for every one of them
+template <int W, int H>
+class PlacedArea
+{
+    public:
+        static const int WIDTH = W;
+        static const int HEIGHT = H;
+
+        // offset has to be a resting position that isn't above the top (see BasicArea::isAboveTop)
+        PlacedArea(const BasicArea<W, H> &area, const Shape &shape, glm::ivec3 offset);
+        PlacedArea(const PlacedArea &) = delete; // layers may point into placed
+        PlacedArea &operator=(const PlacedArea &) = delete;
+
+        const LayerMask<W> &getOccupancy(int y) const { return *layers[y]; }
+        int getRowsCleared() const { return rowsCleared; }
+        uint64_t getHash() const { return hash; } // same as BasicArea::getHash() after addShape() and clearFullLayers()
+
+    private:
+        const LayerMask<W> *layers[H];
+        LayerMask<W> placed[SHAPE_WIDTH]; // layers touched by the Shape, by Shape layer
+        int rowsCleared = 0;
+        uint64_t hash;
+};
+
+template <int W, int H>
+void BasicArea<W, H>::addBlock(int x, int y, int z, int material)
+{
+    Layer &layer = layers[layerSlots[y]];
+    layer.occupancy.set(getCellBit(x, z));
+    materials[layerSlots[y]][getCellBit(x, z)] = material;
+    layer.count++;
+
+    hash ^= getLayerKey(layer.hash, y);
+    layer.hash ^= getCellKey(getCellBit(x, z));
+    hash ^= getLayerKey(layer.hash, y);
+
+    if (heights[getCellBit(x, z)] < y + 1)
+        heights[getCellBit(x, z)] = y + 1;
+}
+
+// Add a block for every cell of Shape at offset
+template <int W, int H>
+void BasicArea<W, H>::addShape(const Shape &shape, glm::ivec3 offset, int material)
+{
+    for (int c = 0; c < shape.count; c++)
+        addBlock(offset.x + shape.cells[c].x, offset.y + shape.cells[c].y, offset.z + shape.cells[c].z, material);
+}
+
+// Remove all filled layers, bringing the layers above them down; returns the number of removed layers
+template <int W, int H>
+int BasicArea<W, H>::clearFullLayers()
+{
+    int slots[H];
+    int kept = 0;
+    for (int j = 0; j < H; j++)
+        if (layers[layerSlots[j]].count < W * W)
+            slots[kept++] = layerSlots[j];
+
+    int cleared = H - kept;
+    if (cleared == 0)
+        return 0;
+
+    // Filled layers are reset once and reused at the top
+    for (int j = 0; j < H; j++)
+        if (layers[layerSlots[j]].count == W * W)
+        {
+            layers[layerSlots[j]] = Layer();
+            std::memset(materials[layerSlots[j]], 0, sizeof(materials[0]));
+            slots[kept++] = layerSlots[j];
+        }
+
+    std::memcpy(layerSlots, slots, sizeof(layerSlots));
+    rebuildHeights();
+
+    // Layers above the cleared ones moved down, so their height in the hash changed
+    hash = 0;
+    for (int j = 0; j < H; j++)
+        hash ^= getLayerKey(getLayer(j).hash, j);
+
+    return cleared;
+}
+
+// Recompute column heights from scratch (after layers were moved around)
+template <int W, int H>
+void BasicArea<W, H>::rebuildHeights()
+{
+    std::memset(heights, 0, sizeof(heights));
+    for (int j = H - 1; j >= 0; j--)
+        for (int w = 0; w < LayerMask<W>::WORDS; w++)
+            for (uint64_t bits = getLayer(j).occupancy.words[w]; bits; bits &= bits - 1)
+            {
+                int bit = w * 64 + std::countr_zero(bits);
+                if (!heights[bit])
+                    heights[bit] = j + 1;
+            }
+}
+
+// Build the occupancy mask of a Shape layer (see Shape::getLayerBits) positioned at (x, z);
+// cells which fall outside of the side border are dropped
+template <int W, int H>
+LayerMask<W> BasicArea<W, H>::getLayerMask(unsigned int shapeBits, int x, int z)
+{
+    LayerMask<W> mask;
+    for (int i = 0; i < SHAPE_WIDTH; i++)
+    {
+        uint64_t row = (shapeBits >> (i * SHAPE_WIDTH)) & ((1u << SHAPE_WIDTH) - 1);
+        if (!row || x + i < 0 || x + i >= W)
+            continue;
+
+        row = z >= 0 ? (row << z) & ROW_MASK : row >> -z;
+        mask.setRun(getCellBit(x + i, 0), row);
+    }
+
+    return mask;
+}
+
+// Check if Shape at offset overlaps any static block
+template <int W, int H>
+bool BasicArea<W, H>::overlaps(const Shape &shape, glm::ivec3 offset) const
+{
+    for (int j = shape.boundsMin.y; j <= shape.boundsMax.y; j++)
+    {
+        int y = offset.y + j;
+        if (y < 0 || y >= H)
+            continue;
+
+        unsigned int bits = shape.getLayerBits(j);
+        if (bits && getLayer(y).occupancy.intersects(getLayerMask(bits, offset.x, offset.z)))
+            return true;
+    }
+
+    return false;
+}
+
+// Check if Shape at offset overlaps any static block or is (partially) below ground
+template <int W, int H>
+bool BasicArea<W, H>::collides(const Shape &shape, glm::ivec3 offset) const
+{
+    if (offset.y + shape.boundsMin.y < 0)
+        return true;
+
+    return overlaps(shape, offset);
+}
+
+// Get the distance Shape at offset can fall before colliding with the ground or a static block
+template <int W, int H>
+int BasicArea<W, H>::getDropDistance(const Shape &shape, glm::ivec3 offset) const
+{
+    const int *bottoms = shape.columnBottoms;
+
+    // Shape lands on the highest column top of its footprint...
+    int landingY = -SHAPE_WIDTH;
+    bool underOverhang = false;
+    for (int c = 0; c < SHAPE_WIDTH * SHAPE_WIDTH; c++)
+    {
+        if (bottoms[c] < 0)
+            continue;
+
+        int columnHeight = getColumnHeight(offset.x + c / SHAPE_WIDTH, offset.z + c % SHAPE_WIDTH);
+        underOverhang |= columnHeight > offset.y + bottoms[c];
+        landingY = std::max(landingY, columnHeight - bottoms[c]);
+    }
+    if (!underOverhang)
+        return offset.y - landingY;
+
+    // ... unless it was moved under an overhang, in which case the column tops are above it
+    int y = offset.y;
+    do
+        y--;
+    while (!collides(shape, glm::ivec3(offset.x, y, offset.z)));
+
+    return offset.y - (y + 1); // (y + 1) = position above collision
+}
+
+template <int W, int H>
+PlacedArea<W, H>::PlacedArea(const BasicArea<W, H> &area, const Shape &shape, glm::ivec3 offset)
+{
+    static const LayerMask<W> empty;
+
+    int counts[SHAPE_WIDTH];
+    uint64_t layerHashes[SHAPE_WIDTH];
+    for (int j = shape.boundsMin.y; j <= shape.boundsMax.y; j++)
+    {
+        const typename BasicArea<W, H>::Layer &layer = area.getLayer(offset.y + j);
+        placed[j] = layer.occupancy;
+        counts[j] = layer.count;
+        layerHashes[j] = layer.hash;
+    }
+    for (int c = 0; c < shape.count; c++)
+    {
+        const ShapeCell &cell = shape.cells[c];
+        int bit = area.getCellBit(offset.x + cell.x, offset.z + cell.z);
+        placed[cell.y].set(bit);
+        counts[cell.y]++;
+        layerHashes[cell.y] ^= getCellKey(bit);
+    }
+
+    // Full layers are left out, the ones above them move down
+    int kept = 0;
+    for (int y = 0; y < H; y++)
+    {
+        int j = y - offset.y;
+        bool touched = j >= shape.boundsMin.y && j <= shape.boundsMax.y;
+        if (touched && counts[j] == W * W)
+            continue;
+        layers[kept++] = touched ? &placed[j] : &area.getOccupancy(y);
+    }
+    rowsCleared = H - kept;
+    while (kept < H)
+        layers[kept++] = &empty;
+
+    if (rowsCleared == 0)
+    {
+        // Only the touched layers changed
+        hash = area.getHash();
+        for (int j = shape.boundsMin.y; j <= shape.boundsMax.y; j++)
+        {
+            int y = offset.y + j;
+            hash ^= getLayerKey(area.getLayer(y).hash, y) ^ getLayerKey(layerHashes[j], y);
+        }
+        return;
+    }
+
+    hash = 0;
+    kept = 0;
+    for (int y = 0; y < H; y++)
+    {
+        int j = y - offset.y;
+        bool touched = j >= shape.boundsMin.y && j <= shape.boundsMax.y;
+        if (touched && counts[j] == W * W)
+            continue;
+        hash ^= getLayerKey(touched ? layerHashes[j] : area.getLayer(y).hash, kept++);
+    }
+}
+
+#endif
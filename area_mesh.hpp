@@ -0,0 +1,183 @@
+#ifndef AREA_MESH_H
+#define AREA_MESH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "area.hpp"
+
+
+struct MeshVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 textureCoords; // in cells, textures repeat once per block
+    int material; // index into materials
+};
+
+// One mesh of all static blocks in an Area, with only the faces that aren't covered by a neighbouring block.
+// Faces are built per layer, and update() only rebuilds the layers next to ones that changed since the last call
+template <int W, int H>
+class AreaMesh
+{
+    public:
+        bool greedy = true; // merge runs of coplanar faces with the same material into single quads
+
+        // Patch the mesh to match area, returns the index of the first vertex that changed (getVertices().size() if none did)
+        size_t update(const BasicArea<W, H> &area);
+
+        const std::vector<MeshVertex> &getVertices() const { return vertices; }
+
+    private:
+        // Contents of a layer when its faces were last built
+        struct CachedLayer
+        {
+            LayerMask<W> occupancy;
+            unsigned char materials[W * W] = { 0 };
+        };
+
+        CachedLayer cache[H];
+        std::vector<MeshVertex> layerVertices[H];
+        std::vector<MeshVertex> vertices; // layerVertices of all layers, bottom up
+
+        void buildLayer(const BasicArea<W, H> &, int y);
+        void addQuad(int direction, glm::ivec3 min, glm::ivec3 max, int material, std::vector<MeshVertex> &out) const;
+};
+
+// Face directions: normal, and the axes of the face (u x v = normal) which fix the winding
+const glm::ivec3 FACE_NORMALS[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+const int FACE_U[6] = { 1, 2, 2, 0, 0, 1 };
+const int FACE_V[6] = { 2, 1, 0, 2, 1, 0 };
+
+template <int W, int H>
+size_t AreaMesh<W, H>::update(const BasicArea<W, H> &area)
+{
+    bool changed[H];
+    for (int y = 0; y < H; y++)
+    {
+        const typename BasicArea<W, H>::Layer &layer = area.getLayer(y);
+        const unsigned char *materials = area.getLayerMaterials(y);
+        changed[y] = std::memcmp(&cache[y].occupancy, &layer.occupancy, sizeof(layer.occupancy)) != 0
+                  || std::memcmp(cache[y].materials, materials, sizeof(cache[y].materials)) != 0;
+        if (changed[y])
+        {
+            cache[y].occupancy = layer.occupancy;
+            std::memcpy(cache[y].materials, materials, sizeof(cache[y].materials));
+        }
+    }
+
+    // Top and bottom faces of a layer also depend on the layers above and below
+    int first = H;
+    for (int y = 0; y < H; y++)
+        if (changed[y] || (y > 0 && changed[y - 1]) || (y + 1 < H && changed[y + 1]))
+        {
+            buildLayer(area, y);
+            first = std::min(first, y);
+        }
+    if (first == H)
+        return vertices.size();
+
+    size_t offset = 0;
+    for (int y = 0; y < first; y++)
+        offset += layerVertices[y].size();
+
+    vertices.resize(offset);
+    for (int y = first; y < H; y++)
+        vertices.insert(vertices.end(), layerVertices[y].begin(), layerVertices[y].end());
+
+    return offset;
+}
+
+template <int W, int H>
+void AreaMesh<W, H>::buildLayer(const BasicArea<W, H> &area, int y)
+{
+    std::vector<MeshVertex> &out = layerVertices[y];
+    out.clear();
+
+    const typename BasicArea<W, H>::Layer &layer = area.getLayer(y);
+    const unsigned char *materials = area.getLayerMaterials(y);
+    if (layer.count == 0)
+        return;
+
+    for (int d = 0; d < 6; d++)
+    {
+        glm::ivec3 n = FACE_NORMALS[d];
+
+        // Area material of every exposed face in this direction (0 for none), indexed like the layer's cells
+        int faces[W * W];
+        for (int x = 0; x < W; x++)
+            for (int z = 0; z < W; z++)
+            {
+                int bit = area.getCellBit(x, z);
+                int nx = x + n.x, ny = y + n.y, nz = z + n.z;
+                bool covered = nx >= 0 && nx < W && ny >= 0 && ny < H && nz >= 0 && nz < W && area.isOccupied(nx, ny, nz);
+                faces[bit] = layer.occupancy.test(bit) && !covered ? materials[bit] : 0;
+            }
+
+        // Faces can only be merged within their plane: side faces along the layer, top and bottom faces over all of it
+        bool alongX = greedy && n.x == 0;
+        bool alongZ = greedy && n.z == 0;
+        for (int x = 0; x < W; x++)
+            for (int z = 0; z < W; z++)
+            {
+                int material = faces[area.getCellBit(x, z)];
+                if (material == 0)
+                    continue;
+
+                int z1 = z;
+                while (alongZ && z1 + 1 < W && faces[area.getCellBit(x, z1 + 1)] == material)
+                    z1++;
+
+                int x1 = x;
+                while (alongX && x1 + 1 < W)
+                {
+                    bool sameRun = true;
+                    for (int k = z; k <= z1 && sameRun; k++)
+                        sameRun = faces[area.getCellBit(x1 + 1, k)] == material;
+                    if (!sameRun)
+                        break;
+                    x1++;
+                }
+
+                for (int i = x; i <= x1; i++)
+                    for (int k = z; k <= z1; k++)
+                        faces[area.getCellBit(i, k)] = 0;
+
+                addQuad(d, glm::ivec3(x, y, z), glm::ivec3(x1, y, z1), material - 1, out);
+            }
+    }
+}
+
+// Two triangles covering face direction of the blocks from min to max (inclusive)
+template <int W, int H>
+void AreaMesh<W, H>::addQuad(int direction, glm::ivec3 min, glm::ivec3 max, int material, std::vector<MeshVertex> &out) const
+{
+    glm::vec3 normal = glm::vec3(FACE_NORMALS[direction]);
+    glm::vec3 low = glm::vec3(min) - 0.5f, high = glm::vec3(max) + 0.5f;
+
+    // Corner where the face starts, on the side of the box the normal points to
+    glm::vec3 origin = low;
+    for (int a = 0; a < 3; a++)
+        if (normal[a] > 0)
+            origin[a] = high[a];
+
+    int u = FACE_U[direction], v = FACE_V[direction];
+    glm::vec3 du(0.0f), dv(0.0f);
+    du[u] = high[u] - low[u];
+    dv[v] = high[v] - low[v];
+
+    MeshVertex corners[4] = {
+        { origin,           normal, glm::vec2(0.0f,  0.0f),  material },
+        { origin + du,      normal, glm::vec2(du[u], 0.0f),  material },
+        { origin + du + dv, normal, glm::vec2(du[u], dv[v]), material },
+        { origin + dv,      normal, glm::vec2(0.0f,  dv[v]), material },
+    };
+    const int order[6] = { 0, 1, 2, 0, 2, 3 }; // counter-clockwise seen from the front
+    for (int i : order)
+        out.push_back(corners[i]);
+}
+
+#endif
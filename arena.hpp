@@ -0,0 +1,78 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// Bump allocator: hands out memory from large blocks and releases all of it at once with reset().
+// Blocks are kept for reuse, so once it has grown to its working size an Arena doesn't allocate anymore.
+// Used by a single thread at a time; aligned so that Arenas of different threads don't share cache lines
+class alignas(64) Arena
+{
+    public:
+        Arena(size_t blockSize = 1 << 20) : blockSize(blockSize) {}
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        Arena(Arena &&) = default;
+
+        void *allocate(size_t size, size_t alignment);
+
+        // Objects are never destroyed, only their memory is reused
+        template <typename T, typename... Args>
+        T *create(Args &&...args)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Arena never calls destructors");
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        void reset() { currentBlock = 0; used = 0; }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<char[]> memory;
+            size_t size;
+        };
+
+        size_t blockSize;
+        std::vector<Block> blocks;
+        size_t currentBlock = 0; // index into blocks
+        size_t used = 0;         // bytes used in the current block
+};
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    while (currentBlock < blocks.size())
+    {
+        Block &block = blocks[currentBlock];
+        uintptr_t start = (uintptr_t) block.memory.get();
+        size_t offset = ((start + used + alignment - 1) & ~(uintptr_t) (alignment - 1)) - start;
+        if (offset + size <= block.size)
+        {
+            used = offset + size;
+            return block.memory.get() + offset;
+        }
+
+        // Try the next block (kept from before the last reset) or get a new one
+        currentBlock++;
+        used = 0;
+    }
+
+    // Extra room for aligning the start of an oversized allocation
+    size_t newSize = std::max(blockSize, size + alignment);
+    blocks.push_back({ std::unique_ptr<char[]>(new char[newSize]), newSize });
+    currentBlock = blocks.size() - 1;
+    used = 0;
+
+    return allocate(size, alignment);
+}
+
+#endif
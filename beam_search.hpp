@@ -0,0 +1,195 @@
+#ifndef BEAM_SEARCH_H
+#define BEAM_SEARCH_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "area.hpp"
+#include "game_core.hpp"
+#include "placement.hpp"
+#include "evaluation.hpp"
+#include "arena.hpp"
+#include "thread_pool.hpp"
+#include "transposition_table.hpp"
+
+
+// Looks depth pieces ahead (the current one, then the PieceSource queue), keeping the width best Areas after every piece.
+// Pieces are locked and layers cleared with the same Area::addShape()/clearFullLayers() as GameCore::processLogic,
+// placements are the ones PathPlanner can reach from where the piece starts. Nodes live in per-thread Arenas which are reset for every decision
+class BeamSearch
+{
+    public:
+        int depth = 3; // pieces to look ahead, at most PIECE_QUEUE_SIZE + 1
+        int width = 16;
+        TranspositionTable *table = nullptr; // optional cache of evaluateArea(), see Bot::table
+
+        // Totals over all plan() calls
+        long long nodes = 0; // evaluated placements
+        double seconds = 0.0;
+
+        BeamSearch(ThreadPool &pool);
+
+        // Best placement for the current piece, orientation -1 if every placement ends the game
+        Placement plan(const Area &, const Player &, const PieceSource &, const BotWeights &);
+
+        double getNodesPerSecond() const { return seconds > 0.0 ? nodes / seconds : 0.0; }
+
+    private:
+        struct Node
+        {
+            Area area;
+            int rowsCleared; // along the path from the root
+            Placement first; // placement of the current piece this path started with
+        };
+
+        struct Candidate
+        {
+            const Node *parent;
+            Placement placement;
+            Placement first;
+            int rowsCleared;
+            double value;
+            uint64_t hash;
+        };
+
+        ThreadPool &pool;
+
+        // Per pool thread
+        std::vector<Arena> arenas;
+        std::vector<std::vector<Placement>> placements;
+        std::vector<PathPlanner<Area::WIDTH, Area::HEIGHT>> planners;
+        std::vector<std::vector<Candidate>> candidates;
+
+        std::vector<const Node *> beam;
+        std::vector<Candidate> merged;
+        std::vector<uint64_t> kept; // hashes of the Areas already in the next beam
+
+        void expand(const Node &, const Player &, bool root, const BotWeights &, int thread);
+        void select();
+};
+
+BeamSearch::BeamSearch(ThreadPool &pool) : pool(pool)
+{
+    int threads = pool.getThreadCount();
+    arenas.resize(threads);
+    placements.resize(threads);
+    planners.resize(threads);
+    candidates.resize(threads);
+}
+
+Placement BeamSearch::plan(const Area &area, const Player &player, const PieceSource &pieces, const BotWeights &weights)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (Arena &arena : arenas)
+        arena.reset();
+
+    Node *root = arenas[0].create<Node>();
+    root->area = area;
+    root->rowsCleared = 0;
+    root->first = { -1, glm::ivec3(0) };
+
+    beam.clear();
+    beam.push_back(root);
+
+    Placement best = root->first;
+    int pieceCount = std::min(depth, PIECE_QUEUE_SIZE + 1);
+    for (int d = 0; d < pieceCount; d++)
+    {
+        // Upcoming pieces start where GameCore spawns them
+        Player piece = player;
+        if (d > 0)
+        {
+            const Piece &next = pieces.peek(d - 1);
+            piece.setShape(next.shapeIndex);
+            piece.setOrientation(next.orientation);
+            piece.offset = glm::ivec3((Area::WIDTH - SHAPE_WIDTH) / 2, Area::HEIGHT - piece.shape.getLowestIndex(), (Area::WIDTH - SHAPE_WIDTH) / 2);
+        }
+
+        for (std::vector<Candidate> &list : candidates)
+            list.clear();
+        pool.parallelFor((int) beam.size(), [&](int i, int thread) {
+            expand(*beam[i], piece, d == 0, weights, thread);
+        });
+
+        select();
+        if (merged.empty())
+            break; // nothing survives this piece, go with the best path so far
+
+        // Survivors become Nodes, each one rebuilt from its parent by the thread that handles it
+        int survivors = std::min((int) merged.size(), width);
+        beam.resize(survivors);
+        pool.parallelFor(survivors, [&](int i, int thread) {
+            const Candidate &candidate = merged[i];
+            const Shape &shape = shapeOrientations[piece.shapeIndex].orientations[candidate.placement.orientation];
+
+            Node *node = arenas[thread].create<Node>();
+            node->area = candidate.parent->area;
+            node->area.addShape(shape, candidate.placement.offset, 1);
+            node->area.clearFullLayers();
+            node->rowsCleared = candidate.rowsCleared;
+            node->first = candidate.first;
+            beam[i] = node;
+        });
+
+        best = merged[0].first;
+    }
+
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return best;
+}
+
+// Score every placement of piece on top of node
+void BeamSearch::expand(const Node &node, const Player &piece, bool root, const BotWeights &weights, int thread)
+{
+    std::vector<Placement> &list = placements[thread];
+    planners[thread].getReachablePlacements(node.area, piece, list);
+
+    const ShapeOrientations &orientations = shapeOrientations[piece.shapeIndex];
+    for (const Placement &placement : list)
+    {
+        const Shape &shape = orientations.orientations[placement.orientation];
+        if (node.area.isAboveTop(shape, placement.offset))
+            continue;
+
+        PlacedArea<Area::WIDTH, Area::HEIGHT> result(node.area, shape, placement.offset); // shares node.area
+        int rowsCleared = node.rowsCleared + result.getRowsCleared();
+
+        // Cleared layers count as complete ones, like in evaluatePlacement()
+        double value = evaluateArea(result, weights, table) + weights.layerCompleteness * rowsCleared;
+        candidates[thread].push_back({ &node, placement, root ? placement : node.first, rowsCleared, value, result.getHash() });
+    }
+}
+
+// Sort candidates of all threads into merged, keeping only the best one of identical Areas (reached in different orders)
+void BeamSearch::select()
+{
+    merged.clear();
+    for (std::vector<Candidate> &list : candidates)
+        merged.insert(merged.end(), list.begin(), list.end());
+    nodes += merged.size();
+
+    // Ties are broken by content, so the result doesn't depend on how the work was split between threads
+    std::sort(merged.begin(), merged.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.value != b.value) return a.value > b.value;
+        if (a.hash != b.hash) return a.hash < b.hash;
+        if (a.first.orientation != b.first.orientation) return a.first.orientation < b.first.orientation;
+        if (a.first.offset.x != b.first.offset.x) return a.first.offset.x < b.first.offset.x;
+        return a.first.offset.z < b.first.offset.z;
+    });
+
+    kept.clear();
+    int count = 0;
+    for (int i = 0; i < (int) merged.size() && count < width; i++)
+        if (std::find(kept.begin(), kept.end(), merged[i].hash) == kept.end())
+        {
+            kept.push_back(merged[i].hash);
+            merged[count++] = merged[i];
+        }
+    merged.resize(count);
+}
+
+#endif
@@ -11,7 +11,11 @@
 
 #include <glm/glm.hpp>
 
-unsigned int loadTexture(const char *path);
+#include "shader.hpp"
+
+#define MAX_MATERIALS 16
+
+unsigned int loadTextureArray(const std::vector<std::string> &paths);
 
 std::string getTagName(const std::string &in);
 std::string getTagValue(const std::string &in);
@@ -27,26 +31,33 @@ struct Vertex
 struct Material
 {
     std::string name;
-    GLuint diffuseTextureID;
-    GLuint specularTextureID;
-    float Ns; // Specular exponent
+    std::string diffusePath;
+    std::string specularPath; // black if there is none
+    float Ns = 0.0f; // Specular exponent
 };
 
 std::vector<Material> materials;
 
+// Material i is layer i of both texture arrays and entry i of the shininess table, so drawing never has to bind textures
+GLuint diffuseTextures, specularTextures;
+GLuint materialTableUBO;
+
+void initMaterials();
+
 class Block
 {
     public:
         GLuint VBO;
         GLuint VAO;
         std::vector<Vertex> vertices;
-        Material material;
+        int materialIndex = 0; // into materials
 
         Block() {};
         Block(const std::string &objPath)
         {
             loadObj(objPath);
             loadMtl("resources/objects/block/materials.mtl");
+            initMaterials();
 
             std::cout << "Materials (" << materials.size() << "):" << std::endl;
             for (Material m : materials)
@@ -78,14 +89,10 @@ class Block
 
         void draw()
         {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, material.diffuseTextureID);
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, material.specularTextureID);
+            glVertexAttribI1i(4, materialIndex); // attribute array 4 is disabled in VAO, so this value is used for every vertex
 
             glBindVertexArray(VAO);
             glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-            glActiveTexture(GL_TEXTURE0);
         }
         void del()
         {
@@ -263,14 +270,14 @@ bool Block::loadMtl(const std::string &mtlPath)
         if (tagName == "map_Kd")
         {
             std::cout << "diff\t" << tagValue << std::endl;
-            currMat.diffuseTextureID = loadTexture(tagValue.c_str());
+            currMat.diffusePath = tagValue;
         }
         
         // Specular texture
         if (tagName == "map_Ks")
         {
             std::cout << "spec\t" << tagValue << std::endl;
-            currMat.specularTextureID = loadTexture(tagValue.c_str());
+            currMat.specularPath = tagValue;
         }
     }
 
@@ -281,6 +288,43 @@ bool Block::loadMtl(const std::string &mtlPath)
     return true;
 }
 
+// Load the textures of all materials into the texture arrays, bound to GL_TEXTURE0 (diffuse) and GL_TEXTURE1 (specular)
+// for good, and upload their shininess to the uniform buffer at MATERIAL_TABLE_BINDING
+void initMaterials()
+{
+    if (materials.size() > MAX_MATERIALS)
+    {
+        std::cout << "Only the first " << MAX_MATERIALS << " of " << materials.size() << " materials are used" << std::endl;
+        materials.resize(MAX_MATERIALS);
+    }
+
+    std::vector<std::string> diffusePaths, specularPaths;
+    for (Material &material : materials)
+    {
+        diffusePaths.push_back(material.diffusePath);
+        specularPaths.push_back(material.specularPath);
+    }
+    diffuseTextures = loadTextureArray(diffusePaths);
+    specularTextures = loadTextureArray(specularPaths);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, diffuseTextures);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, specularTextures);
+    glActiveTexture(GL_TEXTURE0);
+
+    // std140 pads every array element to 16 bytes
+    glm::vec4 shininess[MAX_MATERIALS] = {};
+    for (size_t i = 0; i < materials.size(); i++)
+        shininess[i].x = materials[i].Ns;
+
+    glGenBuffers(1, &materialTableUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, materialTableUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(shininess), shininess, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_TABLE_BINDING, materialTableUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
 std::string getTagName(const std::string &in)
 {
     size_t nameStart = in.find_first_not_of(" \t");
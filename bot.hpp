@@ -0,0 +1,177 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "area.hpp"
+#include "game_core.hpp"
+#include "placement.hpp"
+#include "evaluation.hpp"
+#include "beam_search.hpp"
+#include "thread_pool.hpp"
+#include "transposition_table.hpp"
+
+
+// BOT
+
+// Choice of the Bot without lookahead: the reachable placement with the best evaluatePlacement().
+// The tuner plays with it as well, so tuned weights are measured on the decisions the Bot actually makes
+class GreedyPlanner
+{
+    public:
+        // Orientation -1 if the piece can't reach any placement; scores on all pool threads if there is a pool
+        Placement choose(const Area &, const Player &, const BotWeights &, TranspositionTable *table = nullptr, ThreadPool *pool = nullptr);
+
+    private:
+        PathPlanner<Area::WIDTH, Area::HEIGHT> planner;
+        std::vector<Placement> placements;
+        std::vector<double> scores;
+};
+
+// Automated player: picks the best placement for every new piece and steers it there through the same
+// transform()/setRotationAxis()/drop() calls that keyboard input uses
+class Bot
+{
+    public:
+        BotWeights weights;
+        int actionsPerUpdate = 1; // inputs issued per update(), raise it to place pieces instantly
+        TranspositionTable *table = nullptr; // optional cache of evaluateArea(), can be shared between Bots on different threads (even with different weights)
+        int lookahead = 1; // pieces considered per decision, more than one searches the piece queue with BeamSearch
+
+        // Subscribes to game events, so the Bot has to outlive game (or at least its use of it)
+        Bot(GameCore &game, BotWeights weights = BotWeights(), int threads = 1);
+
+        // Call once per frame (before GameCore::step)
+        void update();
+        // Choose a new target for the current piece (done automatically for every spawned piece)
+        void plan();
+
+        BeamSearch &getSearch() { return search; } // beam width and throughput
+
+    private:
+        GameCore &game;
+        ThreadPool pool;
+        BeamSearch search;
+        GreedyPlanner greedy;
+        PathPlanner<Area::WIDTH, Area::HEIGHT> planner;
+
+        bool shouldPlan = false;
+        bool dropped = true;
+        std::vector<Input> inputs; // leading to the target placement, followed by a drop
+        int nextInput = 0;
+
+        void planInputs(const Placement &target);
+        bool act();
+};
+
+Placement GreedyPlanner::choose(const Area &area, const Player &player, const BotWeights &weights, TranspositionTable *table, ThreadPool *pool)
+{
+    // Only placements the piece can actually be steered to
+    planner.getReachablePlacements(area, player, placements);
+    if (placements.empty())
+        return { -1, glm::ivec3(0) };
+
+    scores.resize(placements.size());
+    const ShapeOrientations &orientations = shapeOrientations[player.shapeIndex];
+    auto score = [&](int i, int) {
+        scores[i] = evaluatePlacement(area, orientations.orientations[placements[i].orientation], placements[i].offset, weights, table);
+    };
+    if (pool)
+        pool->parallelFor((int) placements.size(), score);
+    else
+        for (int i = 0; i < (int) placements.size(); i++)
+            score(i, 0);
+
+    return placements[std::max_element(scores.begin(), scores.end()) - scores.begin()];
+}
+
+Bot::Bot(GameCore &game, BotWeights weights, int threads) : weights(weights), game(game), pool(threads), search(pool)
+{
+    game.subscribe([this](const GameEvent &event) {
+        if (event.type == PIECE_SPAWNED || event.type == SNAPSHOT_RESTORED)
+            shouldPlan = true;
+    });
+}
+
+void Bot::update()
+{
+    if (game.state != ACTIVE)
+        return;
+
+    if (shouldPlan)
+    {
+        shouldPlan = false;
+        plan();
+    }
+
+    for (int i = 0; i < actionsPerUpdate && act(); i++)
+        ;
+}
+
+// Choose target placement for the current piece, scoring placements on all pool threads
+void Bot::plan()
+{
+    if (lookahead > 1)
+    {
+        search.depth = lookahead;
+        search.table = table;
+        planInputs(search.plan(game.area, game.player, game.pieces, weights));
+        return;
+    }
+
+    planInputs(greedy.choose(game.area, game.player, weights, table, &pool));
+}
+
+// Every placement ends the game (orientation -1) or target can't be reached: just let the piece fall where it is
+void Bot::planInputs(const Placement &target)
+{
+    inputs.clear();
+    nextInput = 0;
+    dropped = false;
+
+    if (target.orientation >= 0)
+    {
+        planner.search(game.area, game.player);
+        planner.getInputs(target, inputs);
+    }
+}
+
+// Issue the next input towards the target; returns false once the piece was dropped
+bool Bot::act()
+{
+    if (dropped)
+        return false;
+
+    if (nextInput == (int) inputs.size())
+    {
+        game.drop();
+        dropped = true;
+        return false;
+    }
+
+    Input input = inputs[nextInput++];
+    if (input.transformation == NONE)
+    {
+        game.setRotationAxis(input.axis);
+        return true;
+    }
+
+    // Release the previous "key", transform() ignores repeated presses otherwise
+    game.transform(NONE);
+
+    Player &player = game.player;
+    glm::ivec3 offset = player.offset;
+    int orientation = player.orientation;
+    game.transform(input.transformation);
+
+    // Blocked (the piece fell into the stack since planning), drop from here
+    if (player.offset.x == offset.x && player.offset.z == offset.z && player.orientation == orientation)
+        nextInput = (int) inputs.size();
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,124 @@
+// Microbenchmark of the board evaluation kernels: checks getBoardStats() against the cell by cell reference,
+// then reports boards evaluated per second for both and for the full heuristic
+//
+// usage: evalbench [boards] [repetitions]
+
+#include "evaluation.hpp"
+#include "piece_source.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Every member of the larger wells gets compiled here, not just what the benchmark calls
+// (select one for the game with -DAREA_WIDTH / -DAREA_HEIGHT)
+template class BasicArea<10, 20>;
+template class BasicArea<16, 40>;
+
+
+// Stack-like random boards: columns of random height with some holes, occasionally cleared
+template <int W, int H>
+std::vector<BasicArea<W, H>> generateBoards(int count, uint64_t seed)
+{
+    Random random(seed);
+    std::vector<BasicArea<W, H>> boards(count);
+    for (BasicArea<W, H> &area : boards)
+    {
+        int cells = random.nextInt(W * W * H / 2);
+        for (int i = 0; i < cells; i++)
+        {
+            int x = random.nextInt(W), z = random.nextInt(W);
+            int y = area.getColumnHeight(x, z) + (random.nextInt(4) == 0); // leave a hole now and then
+            if (y < H)
+                area.addBlock(x, y, z, 1);
+        }
+        area.clearFullLayers();
+    }
+
+    return boards;
+}
+
+template <int W, int H>
+bool statsEqual(const BoardStats<W, H> &a, const BoardStats<W, H> &b)
+{
+    return a.maxHeight == b.maxHeight && a.holes == b.holes && a.coveredCells == b.coveredCells
+        && std::memcmp(a.heights, b.heights, sizeof(a.heights)) == 0
+        && std::memcmp(a.layerFill, b.layerFill, sizeof(a.layerFill)) == 0;
+}
+
+// Boards per second of f, which is called with every board repetitions times
+template <typename Board, typename F>
+double measure(const std::vector<Board> &boards, int repetitions, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repetitions; r++)
+        for (const Board &board : boards)
+            f(board);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return boards.size() * (double) repetitions / seconds;
+}
+
+// Results of the measured work end up here, so it can't be optimized away
+volatile long long benchmarkSink;
+
+template <int W, int H>
+bool benchmark(int count, int repetitions)
+{
+    std::vector<BasicArea<W, H>> boards = generateBoards<W, H>(count, W * 1000 + H);
+
+    BoardStats<W, H> reference, stats;
+    for (const BasicArea<W, H> &area : boards)
+    {
+        getBoardStatsReference(area, reference);
+        getBoardStats(area, stats);
+        if (!statsEqual(reference, stats))
+        {
+            std::cout << W << "x" << W << "x" << H << ": getBoardStats() differs from the reference" << std::endl;
+            return false;
+        }
+    }
+
+    // A score read from the table has to be the same as the computed one, or shared tables make searches nondeterministic
+    BotWeights weights;
+    TranspositionTable table(16);
+    for (const BasicArea<W, H> &area : boards)
+    {
+        double cold = evaluateArea(area, weights, &table);
+        double warm = evaluateArea(area, weights, &table);
+        if (cold != warm || cold != evaluateArea(area, weights))
+        {
+            std::cout << W << "x" << W << "x" << H << ": evaluateArea() differs between a cold and a warm table" << std::endl;
+            return false;
+        }
+    }
+
+    long long sink = 0;
+    double referenceRate = measure(boards, repetitions, [&](const BasicArea<W, H> &area) { getBoardStatsReference(area, stats); sink += stats.holes; });
+    double kernelRate = measure(boards, repetitions, [&](const BasicArea<W, H> &area) { getBoardStats(area, stats); sink += stats.holes; });
+    double evaluateRate = measure(boards, repetitions, [&](const BasicArea<W, H> &area) { sink += (long long) evaluateArea(area, weights); });
+    benchmarkSink = sink;
+
+    std::cout << std::setw(10) << (std::to_string(W) + "x" + std::to_string(W) + "x" + std::to_string(H))
+              << "  reference " << std::setw(12) << referenceRate
+              << "  kernel " << std::setw(12) << kernelRate
+              << "  evaluateArea " << std::setw(12) << evaluateRate
+              << "  boards/s  (speedup " << kernelRate / referenceRate << "x)" << std::endl;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int boards = argc > 1 ? std::stoi(argv[1]) : 4096;
+    int repetitions = argc > 2 ? std::stoi(argv[2]) : 50;
+
+    std::cout << std::fixed << std::setprecision(0);
+    bool ok = benchmark<AREA_WIDTH, AREA_HEIGHT>(boards, repetitions)
+           && benchmark<10, 20>(boards, repetitions)
+           && benchmark<16, 40>(boards, repetitions / 4 + 1);
+
+    return ok ? 0 : 1;
+}
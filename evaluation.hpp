@@ -0,0 +1,230 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "area.hpp"
+#include "shape.hpp"
+#include "transposition_table.hpp"
+#include "zobrist.hpp"
+
+
+// Weights of the placement heuristic, applied to the Area after the piece locked and full layers were cleared
+struct BotWeights
+{
+    double holes = -6.0;              // empty cells below the top of their column
+    double aggregateHeight = -0.3;    // sum of column heights
+    double layerCompleteness = 10.0;  // sum of squared layer fill ratios, every cleared layer counts as 1
+    double wellDepth = -0.5;          // sum of column depths below their lowest neighbour (borders count as walls)
+    double coveredCells = 0.0;        // occupied cells above a hole in their column
+};
+
+// Fingerprint of the weights, mixed into table keys so evaluations with different weights never share entries
+uint64_t getWeightsKey(const BotWeights &weights)
+{
+    uint64_t key = 0;
+    for (double weight : { weights.holes, weights.aggregateHeight, weights.layerCompleteness, weights.wellDepth, weights.coveredCells })
+        key = mixHash(key ^ std::bit_cast<uint64_t>(weight));
+    return key;
+}
+
+
+// BOARD KERNELS
+
+// Per-cell statistics of an Area that the heuristic is built from
+template <int W, int H>
+struct BoardStats
+{
+    unsigned char heights[W * W]; // per column (bit as in LayerMask), y-index above its highest block
+    int layerFill[H];             // occupied cells per layer
+    int maxHeight;                // highest column
+    int holes;                    // empty cells below the top of their column
+    int coveredCells;             // occupied cells above a hole in their column
+};
+
+// Cell by cell reference for getBoardStats()
+template <int W, int H>
+void getBoardStatsReference(const BasicArea<W, H> &area, BoardStats<W, H> &stats)
+{
+    stats.maxHeight = stats.holes = stats.coveredCells = 0;
+    for (int y = 0; y < H; y++)
+        stats.layerFill[y] = 0;
+
+    for (int x = 0; x < W; x++)
+        for (int z = 0; z < W; z++)
+        {
+            int height = 0;
+            for (int y = 0; y < H; y++)
+                if (area.isOccupied(x, y, z))
+                {
+                    height = y + 1;
+                    stats.layerFill[y]++;
+                }
+
+            bool holeBelow = false;
+            for (int y = 0; y < height; y++)
+            {
+                bool occupied = area.isOccupied(x, y, z);
+                stats.holes += !occupied;
+                stats.coveredCells += occupied && holeBelow;
+                holeBelow |= !occupied;
+            }
+
+            stats.heights[area.getCellBit(x, z)] = height;
+            stats.maxHeight = std::max(stats.maxHeight, height);
+        }
+}
+
+// Same as getBoardStatsReference(), but on whole layer bitmasks: every operation handles 64 cells at once,
+// and the work only depends on the number of layers (plus one write per column for the heights).
+// A is a BasicArea<W, H> or a PlacedArea<W, H>
+template <typename A, int W, int H>
+void getBoardStats(const A &area, BoardStats<W, H> &stats)
+{
+    const int WORDS = LayerMask<W>::WORDS;
+
+    // Top down: a cell is a hole if it is empty and some cell above it is occupied
+    uint64_t above[WORDS] = { 0 };
+    uint64_t holeMasks[H][WORDS];
+    stats.maxHeight = stats.holes = 0;
+    for (int y = H - 1; y >= 0; y--)
+    {
+        const uint64_t *occupied = area.getOccupancy(y).words;
+        int fill = 0;
+        for (int w = 0; w < WORDS; w++)
+        {
+            holeMasks[y][w] = ~occupied[w] & above[w];
+            stats.holes += std::popcount(holeMasks[y][w]);
+            fill += std::popcount(occupied[w]);
+
+            // Columns topped out in this layer
+            for (uint64_t top = occupied[w] & ~above[w]; top; top &= top - 1)
+                stats.heights[w * 64 + std::countr_zero(top)] = y + 1;
+            above[w] |= occupied[w];
+        }
+        stats.layerFill[y] = fill;
+        if (fill && !stats.maxHeight)
+            stats.maxHeight = y + 1;
+    }
+
+    // Columns without blocks
+    for (int w = 0; w < WORDS; w++)
+        for (uint64_t empty = ~above[w]; empty; empty &= empty - 1)
+        {
+            int bit = w * 64 + std::countr_zero(empty);
+            if (bit >= W * W)
+                break;
+            stats.heights[bit] = 0;
+        }
+
+    // Bottom up: an occupied cell is covered if there is a hole below it
+    uint64_t holeBelow[WORDS] = { 0 };
+    stats.coveredCells = 0;
+    for (int y = 0; y < stats.maxHeight; y++)
+    {
+        const uint64_t *occupied = area.getOccupancy(y).words;
+        for (int w = 0; w < WORDS; w++)
+        {
+            stats.coveredCells += std::popcount(occupied[w] & holeBelow[w]);
+            holeBelow[w] |= holeMasks[y][w];
+        }
+    }
+}
+
+
+// HEURISTIC
+
+struct AreaFeatures
+{
+    int holes = 0;
+    int aggregateHeight = 0;
+    double layerCompleteness = 0.0;
+    int wellDepth = 0;
+    int coveredCells = 0;
+};
+
+template <typename A>
+AreaFeatures getAreaFeatures(const A &area)
+{
+    const int W = A::WIDTH, H = A::HEIGHT;
+    BoardStats<W, H> stats;
+    getBoardStats(area, stats);
+
+    AreaFeatures features;
+    features.holes = stats.holes;
+    features.coveredCells = stats.coveredCells;
+
+    // Heights with a border of walls as high as the Area, so every column has four neighbours
+    const int P = W + 2;
+    unsigned char padded[P * P];
+    std::memset(padded, H, sizeof(padded));
+    for (int x = 0; x < W; x++)
+        std::memcpy(padded + (x + 1) * P + 1, stats.heights + x * W, W);
+
+    // Plain loops over bytes, which compilers vectorize
+    for (int x = 1; x <= W; x++)
+        for (int z = 1; z <= W; z++)
+        {
+            int height = padded[x * P + z];
+            int lowestNeighbour = std::min(std::min(padded[(x - 1) * P + z], padded[(x + 1) * P + z]),
+                                           std::min(padded[x * P + z - 1], padded[x * P + z + 1]));
+            features.aggregateHeight += height;
+            features.wellDepth += std::max(0, lowestNeighbour - height);
+        }
+
+    int squaredFill = 0;
+    for (int y = 0; y < stats.maxHeight; y++)
+        squaredFill += stats.layerFill[y] * stats.layerFill[y];
+    features.layerCompleteness = (double) squaredFill / (W * W * W * W);
+
+    return features;
+}
+
+// Static score of an Area, higher is better; with a table, every distinct Area is only evaluated once per set of weights.
+// Scores are rounded to the float the table stores, so a cached score is the same as a computed one
+template <typename A>
+double evaluateArea(const A &area, const BotWeights &weights, TranspositionTable *table = nullptr)
+{
+    uint64_t key = 0;
+    TranspositionTable::Entry entry;
+    if (table)
+    {
+        key = area.getHash() ^ getWeightsKey(weights);
+        if (table->probe(key, entry))
+            return entry.value;
+    }
+
+    AreaFeatures features = getAreaFeatures(area);
+    double value = weights.holes * features.holes
+                 + weights.aggregateHeight * features.aggregateHeight
+                 + weights.layerCompleteness * features.layerCompleteness
+                 + weights.wellDepth * features.wellDepth
+                 + weights.coveredCells * features.coveredCells;
+    value = (float) value;
+
+    if (table)
+        table->store(key, { (float) value, 0 });
+    return value;
+}
+
+// Score of locking Shape at offset (offset must be a resting position), higher is better;
+// placements that end the game score -infinity
+template <int W, int H>
+double evaluatePlacement(const BasicArea<W, H> &area, const Shape &shape, glm::ivec3 offset, const BotWeights &weights, TranspositionTable *table = nullptr)
+{
+    if (area.isAboveTop(shape, offset))
+        return -std::numeric_limits<double>::infinity();
+
+    PlacedArea<W, H> result(area, shape, offset);
+
+    // Cleared layers count as complete ones
+    return evaluateArea(result, weights, table) + weights.layerCompleteness * result.getRowsCleared();
+}
+
+#endif
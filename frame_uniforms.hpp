@@ -0,0 +1,108 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <vector>
+
+#include "shader.hpp"
+
+#define NR_POINT_LIGHTS 4 // same as in my_shader.frag
+
+
+// The structs mirror the std140 layout of the uniform blocks in the shaders: a float right after a vec3 shares its
+// 16 bytes, everything else that would straddle them gets explicit padding
+
+// Frame block: camera state
+struct FrameBlock
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+struct DirectionalLightBlock
+{
+    glm::vec3 direction; // towards the light
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+struct PointLightBlock
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float padding;
+};
+// Lights block: dirLight and pointLights
+struct LightsBlock
+{
+    DirectionalLightBlock dirLight;
+    PointLightBlock pointLights[NR_POINT_LIGHTS];
+};
+static_assert(sizeof(FrameBlock) == 144 && sizeof(DirectionalLightBlock) == 64 && sizeof(PointLightBlock) == 64, "Not the std140 layout");
+
+// Camera and light state shared by every program. Both blocks live in one buffer, bound to FRAME_BINDING and
+// LIGHTS_BINDING, so a frame costs a single upload no matter how many programs read them
+class FrameUniforms
+{
+    public:
+        FrameBlock frame = {};
+        LightsBlock lights = {};
+
+        void init();
+        void del();
+
+        // Upload frame and lights as they are now, call once per frame before drawing
+        void upload();
+
+    private:
+        unsigned int UBO = 0;
+        size_t lightsOffset = 0; // Lights block ranges have to start at a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        std::vector<unsigned char> staging;
+};
+
+void FrameUniforms::init()
+{
+    int alignment;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    lightsOffset = (sizeof(FrameBlock) + alignment - 1) / alignment * alignment;
+    staging.assign(lightsOffset + sizeof(LightsBlock), 0);
+
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, staging.size(), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BINDING, UBO, 0, sizeof(FrameBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHTS_BINDING, UBO, lightsOffset, sizeof(LightsBlock));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void FrameUniforms::del()
+{
+    glDeleteBuffers(1, &UBO);
+}
+
+void FrameUniforms::upload()
+{
+    std::memcpy(staging.data(), &frame, sizeof(FrameBlock));
+    std::memcpy(staging.data() + lightsOffset, &lights, sizeof(LightsBlock));
+
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, staging.size(), staging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+#endif
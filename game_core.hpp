@@ -0,0 +1,583 @@
+#ifndef GAME_CORE_H
+#define GAME_CORE_H
+
+#include <glm/glm.hpp>
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "shape.hpp"
+#include "area.hpp"
+#include "piece_source.hpp"
+
+#include "constants.hpp"
+
+
+// PLAYER
+
+class Player
+{
+    public:
+        Shape shape = shapeOrientations[0].orientations[0];
+        int shapeIndex = 0;
+        int orientation = 0; // index into shapeOrientations[shapeIndex]
+        int materialIndex = 1;
+        glm::ivec3 prevOffset = glm::ivec3(0);
+        glm::ivec3 offset = glm::ivec3(0); // offset within Area
+        Axis rotationAxis = AXIS_Y;
+
+        void setShape(int index) { shapeIndex = index; setOrientation(0); }
+        void setOrientation(int o) { orientation = o; shape = shapeOrientations[shapeIndex].orientations[o]; }
+        void setMaterial(int matIndex) { materialIndex = matIndex; };
+
+        int getRotatedOrientation(Axis axis, Transformation rd) const { return shapeOrientations[shapeIndex].next[orientation][axis][getRotationIndex(rd)]; }
+        void rotate(Axis axis, Transformation rd) { setOrientation(getRotatedOrientation(axis, rd)); }
+};
+
+// Put the next piece from pieces into Player, horizontally centered in area (height is left to the caller)
+Piece spawnPiece(Player &player, PieceSource &pieces, const Area &area)
+{
+    Piece piece = pieces.next();
+    player.setShape(piece.shapeIndex);
+    player.setOrientation(piece.orientation); // initial rotation is randomized by PieceSource
+    player.setMaterial(piece.shapeIndex + 1);
+
+    player.offset.x = (area.WIDTH - SHAPE_WIDTH) / 2;
+    player.offset.z = (area.WIDTH - SHAPE_WIDTH) / 2;
+
+    return piece;
+}
+
+// Get the distance Player can fall before colliding with the ground or a static block
+int getPreviewOffset(const Player &player, const Area &area)
+{
+    return area.getDropDistance(player.shape, player.offset);
+}
+
+// Hash of the static blocks and the active piece (Shape and orientation, not its position)
+uint64_t getStateHash(const Player &player, const Area &area)
+{
+    return area.getHash() ^ getPieceKey(player.shapeIndex, player.orientation);
+}
+
+// GAME
+
+enum State {
+    ACTIVE,
+    PAUSED,
+    OVER
+};
+
+enum GameEventType {
+    PIECE_SPAWNED,  // value: shape index
+    PIECE_MOVED,    // value: unused
+    PIECE_ROTATED,  // value: new orientation
+    PIECE_LOCKED,   // value: score gained
+    ROWS_CLEARED,   // value: number of rows cleared
+    STATE_CHANGED,  // value: new State
+    SPEED_CHANGED,  // value: unused, read GameCore::speed
+    SNAPSHOT_RESTORED // value: unused, everything may have changed
+};
+struct GameEvent
+{
+    GameEventType type;
+    int value;
+};
+typedef std::function<void(const GameEvent &)> GameEventListener;
+
+// Running totals of a game, kept up to date by subscribing to GameCore events
+struct GameStats
+{
+    int piecesSpawned = 0;
+    int piecesLocked = 0;
+    int moves = 0;
+    int rotations = 0;
+    int rowsCleared = 0;
+
+    void onEvent(const GameEvent &event)
+    {
+        if (event.type == PIECE_SPAWNED) piecesSpawned++;
+        else if (event.type == PIECE_LOCKED) piecesLocked++;
+        else if (event.type == PIECE_MOVED) moves++;
+        else if (event.type == PIECE_ROTATED) rotations++;
+        else if (event.type == ROWS_CLEARED) rowsCleared += event.value;
+    }
+};
+
+// GAME STATE
+
+// Value snapshot of a game (without timing), for search and undo. Copies share the Area until one of them
+// modifies it (copy-on-write), so fork() is O(1) no matter the Area size and reading a snapshot never copies
+class GameState
+{
+    public:
+        State state = ACTIVE;
+        int score = 0;
+        double speed = 1.0;
+        Player player;
+        PieceSource pieces;
+
+        GameState() : area(std::make_shared<Area>()) {}
+        explicit GameState(const Area &area) : area(std::make_shared<Area>(area)) {}
+
+        GameState fork() const { return *this; }
+
+        const Area &getArea() const { return *area; }
+        Area &getMutableArea(); // clones the Area first if it is shared
+        bool sharesAreaWith(const GameState &other) const { return area == other.area; }
+
+        void spawn();
+        int place(int orientation, glm::ivec3 offset);
+
+    private:
+        std::shared_ptr<Area> area;
+};
+
+Area &GameState::getMutableArea()
+{
+    if (area.use_count() > 1)
+        area = std::make_shared<Area>(*area);
+
+    return *area;
+}
+
+// Spawn the next piece right above the Area
+void GameState::spawn()
+{
+    spawnPiece(player, pieces, *area);
+    player.offset.y = area->HEIGHT - player.shape.getLowestIndex();
+}
+
+// Lock the Player's piece in orientation at offset, which has to be a resting position (see getPlacements),
+// clear full layers and spawn the next piece; returns the number of cleared layers.
+// Follows the GameCore rules, except that there is no disco mode bonus
+int GameState::place(int orientation, glm::ivec3 offset)
+{
+    if (state != ACTIVE)
+        return 0;
+
+    player.setOrientation(orientation);
+    player.offset = offset;
+    if (area->isAboveTop(player.shape, offset))
+    {
+        state = OVER;
+        return 0;
+    }
+
+    Area &mutableArea = getMutableArea();
+    mutableArea.addShape(player.shape, offset, player.materialIndex);
+    score += player.shape.count;
+
+    int rowsCleared = mutableArea.clearFullLayers();
+    if (rowsCleared >= 1)
+        speed += 0.1;
+
+    spawn();
+    return rowsCleared;
+}
+
+
+// Game rules without any rendering or windowing; time only advances through step(), in fixed logic ticks
+class GameCore
+{
+    public:
+        State state = ACTIVE;
+        double speed = 1.0f;
+        int score = 0;
+        bool discoMode = false;
+        bool discoInitiated = false;
+        bool logging = true; // print debug output to std::cout
+        double tickRate = 60.0; // logic updates per second, independent of the frame rate
+
+        Player player;
+        Area area;
+        PieceSource pieces; // reset() with a seed for a reproducible game
+
+
+        void step(double dt);
+        glm::vec3 getInterpolatedOffset() const;
+
+        void transform(Transformation);
+        void drop();
+
+        void setRotationAxis(Axis);
+        void setState(State);
+
+        void subscribe(GameEventListener listener) { listeners.push_back(listener); }
+
+        GameState getSnapshot() const;
+        void restoreSnapshot(const GameState &);
+
+    protected:
+        double time = 0.0; // game time in seconds, only advances while the game is active
+        double accumulator = 0.0; // time not yet consumed by a logic tick
+        glm::ivec3 previousOffset = glm::ivec3(0); // Player offset before the last logic tick
+        bool snapOffset = false; // Player was (re)spawned, don't interpolate from its previous position
+        int tick = 0;
+        double tickOffset = 0;
+        double tickDropOffset = 0;
+        int dropOffset = 0;
+        int initLowestIndex = 0;
+
+        bool keyPressed = false;
+        bool shouldSpawnNewBlock = true;
+        bool collisionDetected = false;
+        bool dropInitiated = false;
+
+        std::vector<GameEventListener> listeners;
+        void publish(GameEventType type, int value = 0);
+
+        void processLogic();
+
+        bool checkCollision(const Shape &);
+        bool detectHorizontalCollision(const Shape &);
+};
+
+// Advance the game by dt seconds, running as many fixed logic ticks as fit
+void GameCore::step(double dt)
+{
+    if (state != ACTIVE)
+        return;
+
+    double tickLength = 1.0 / tickRate;
+    accumulator += dt;
+    while (accumulator >= tickLength && state == ACTIVE)
+    {
+        accumulator -= tickLength;
+        time += tickLength;
+
+        previousOffset = player.offset;
+        processLogic();
+        if (snapOffset)
+        {
+            previousOffset = player.offset;
+            snapOffset = false;
+        }
+    }
+}
+
+// Player offset for rendering, interpolated between the last two logic ticks
+glm::vec3 GameCore::getInterpolatedOffset() const
+{
+    if (state != ACTIVE)
+        return glm::vec3(player.offset.x, player.offset.y, player.offset.z);
+
+    float t = (float) (accumulator * tickRate);
+    return glm::vec3(previousOffset.x + (player.offset.x - previousOffset.x) * t,
+                     previousOffset.y + (player.offset.y - previousOffset.y) * t,
+                     previousOffset.z + (player.offset.z - previousOffset.z) * t);
+}
+
+void GameCore::processLogic()
+{
+    if (state != ACTIVE)
+        return;
+    // TODO: posebna funkcija za procesiranje akcija kad je igra pauzirana
+
+
+    int &pox = player.offset.x;
+    int &poy = player.offset.y;
+    int &poz = player.offset.z;
+
+    // Update Player shape if 1) game started, or 2) new "level" started
+    if (shouldSpawnNewBlock)
+    {
+        Piece piece = spawnPiece(player, pieces, area);
+        if (logging)
+            std::cout << "Piece " << piece.shapeIndex << std::endl;
+
+        shouldSpawnNewBlock = false;
+        dropOffset = 0;
+        initLowestIndex = player.shape.getLowestIndex(); // to prevent updates when rotating
+        snapOffset = true;
+
+        publish(PIECE_SPAWNED, piece.shapeIndex);
+    }
+
+    // Tick logic
+    tick = time * 1.25f * speed - tickOffset - tickDropOffset;
+
+    
+    
+
+    int newY = area.HEIGHT - initLowestIndex - tick - dropOffset;
+    if (newY != poy)
+    {
+        poy = newY;
+        publish(PIECE_MOVED);
+    }
+
+
+    // Prevent unnecessary calculations if Player didn't move
+    if (player.prevOffset == player.offset)
+        return;
+    
+    player.prevOffset = player.offset;
+   
+    
+    // If no collision was detected, move to next frame
+    collisionDetected = checkCollision(player.shape);
+    if (!collisionDetected)
+        return;
+    
+    // Collision detected
+    
+    // Check if locking Player shape in place would cause Game Over (Shape cells are connected, so some cell is in the top row)
+    if (area.isAboveTop(player.shape, glm::ivec3(pox, poy + 1, poz)))
+    {
+        if (logging)
+            std::cout << "over" << std::endl;
+        poy++; // This way the player is rendered above the collision
+        setState(OVER);
+        return;
+    }
+
+    // Lock the Player in place
+    area.addShape(player.shape, glm::ivec3(pox, poy + 1, poz), player.materialIndex); // (y + 1) since collision happened at (y)
+    
+    // Scoring
+    int points = discoMode ? player.shape.count * 3 : player.shape.count;
+    score += points;
+    publish(PIECE_LOCKED, points);
+
+    // Check if any rows got filled up; if so, clear them
+    int rowsCleared = area.clearFullLayers();
+    if (rowsCleared >= 1)
+    {
+        // Increase speed only once, no matter how many rows were cleared
+        speed += 0.1;
+        publish(SPEED_CHANGED);
+        publish(ROWS_CLEARED, rowsCleared);
+
+        discoMode = true;
+        discoInitiated = true;
+        if (logging)
+            std::cout << "Start disco!!!" << std::endl;
+    }
+
+
+
+    if (logging)
+        std::cout << "Level ended at:\t" << time * 1.25f * speed - tickOffset << std::endl;
+    // Signal new level
+    dropOffset = 0;
+    tickOffset = time * 1.25f * speed;
+    tickDropOffset = 0.0;
+    shouldSpawnNewBlock = true;
+}
+
+// Copy of the game state; the Area is copied once here, forks of the snapshot share it.
+// Between a lock and the next tick Player still holds the locked piece, which is already part of the Area;
+// the snapshot gets the next piece instead, spawned from its own copy of pieces just like the next tick would
+GameState GameCore::getSnapshot() const
+{
+    GameState snapshot(area);
+    snapshot.state = state;
+    snapshot.score = score;
+    snapshot.speed = speed;
+    snapshot.player = player;
+    snapshot.pieces = pieces;
+    if (shouldSpawnNewBlock && state != OVER)
+        snapshot.spawn();
+
+    return snapshot;
+}
+
+// Continue the game from snapshot (e.g. undo), with the piece falling on from the snapshot's position
+// (snapshot.player is always a live piece, see getSnapshot)
+void GameCore::restoreSnapshot(const GameState &snapshot)
+{
+    area = snapshot.getArea();
+    score = snapshot.score;
+    speed = snapshot.speed;
+    player = snapshot.player;
+    pieces = snapshot.pieces;
+
+    // Restart the gravity timer so the tick logic keeps Player at its restored height
+    shouldSpawnNewBlock = false;
+    initLowestIndex = player.shape.getLowestIndex();
+    tickOffset = time * 1.25f * speed;
+    tickDropOffset = 0.0;
+    dropOffset = area.HEIGHT - initLowestIndex - player.offset.y;
+    player.prevOffset = glm::ivec3(-1); // check for collision on the next tick
+    previousOffset = player.offset; // don't interpolate from before the restore
+
+    publish(SNAPSHOT_RESTORED);
+    setState(snapshot.state);
+}
+
+void GameCore::publish(GameEventType type, int value)
+{
+    GameEvent event = { type, value };
+    for (GameEventListener &listener : listeners)
+        listener(event);
+}
+
+void GameCore::setState(State newState)
+{
+    if (state == newState)
+        return;
+
+    state = newState;
+    publish(STATE_CHANGED, newState);
+}
+
+void GameCore::transform(Transformation transform)
+{
+    if (state != ACTIVE)
+        return;
+
+    if (transform == NONE)
+    {
+        keyPressed = false;
+        return;
+    }
+
+    if (keyPressed)
+        return;
+
+    int &pox = player.offset.x;
+    int &poy = player.offset.y;
+    int &poz = player.offset.z;
+
+
+    if (transform == TRANS_BACKWARD)
+    {
+        keyPressed = true;
+
+        // Check for collision with border...
+        if (poz + player.shape.boundsMin.z - 1 < 0)
+            return;
+
+        // ... or with other static blocks
+        if (area.overlaps(player.shape, glm::ivec3(pox, poy, poz - 1)))
+            return;
+
+        player.offset.z -= 1; // forward is in the direction of -z
+        publish(PIECE_MOVED);
+    }
+    else if (transform == TRANS_FORWARD)
+    {
+        keyPressed = true;
+
+        // Check for collision with border...
+        if (poz + player.shape.boundsMax.z + 1 >= area.WIDTH)
+            return;
+
+        // ... or with other static blocks
+        if (area.overlaps(player.shape, glm::ivec3(pox, poy, poz + 1)))
+            return;
+        
+        player.offset.z += 1; // backward is in the direction of +z
+        publish(PIECE_MOVED);
+    }
+    else if (transform == TRANS_RIGHT)
+    {
+        keyPressed = true;
+
+        // Check for collision with border...
+        if (pox + player.shape.boundsMin.x - 1 < 0)
+            return;
+
+        // ... or with other static blocks
+        if (area.overlaps(player.shape, glm::ivec3(pox - 1, poy, poz)))
+            return;
+        
+        player.offset.x -= 1; // backward is in the direction of +z
+        publish(PIECE_MOVED);
+    }
+    else if (transform == TRANS_LEFT)
+    {
+        keyPressed = true;
+
+        // Check for collision with border...
+        if (pox + player.shape.boundsMax.x + 1 >= area.WIDTH)
+            return;
+
+        // ... or with other static blocks
+        if (area.overlaps(player.shape, glm::ivec3(pox + 1, poy, poz)))
+            return;
+
+        player.offset.x += 1; // backward is in the direction of +z
+        publish(PIECE_MOVED);
+    }
+
+    else if (transform == ROT_CCW)
+    {
+        keyPressed = true;
+        int rotated = player.getRotatedOrientation(player.rotationAxis, ROT_CCW);
+        if (!detectHorizontalCollision(shapeOrientations[player.shapeIndex].orientations[rotated]))
+        {
+            player.setOrientation(rotated);
+            publish(PIECE_ROTATED, rotated);
+        }
+    }
+    else if (transform == ROT_CW)
+    {
+        keyPressed = true;
+        int rotated = player.getRotatedOrientation(player.rotationAxis, ROT_CW);
+        if (!detectHorizontalCollision(shapeOrientations[player.shapeIndex].orientations[rotated]))
+        {
+            player.setOrientation(rotated);
+            publish(PIECE_ROTATED, rotated);
+        }
+    }
+}
+
+void GameCore::drop()
+{
+    dropOffset += getPreviewOffset(player, area);
+    tickDropOffset = time * 1.25f * speed - tickOffset - (int)(time * 1.25f * speed - tickOffset);
+}
+
+void GameCore::setRotationAxis(Axis newAxis)
+{
+    player.rotationAxis = newAxis;
+}
+
+// REVIEW: preimenuj u detect*Vertical*Collision
+bool GameCore::checkCollision(const Shape &shape)
+{
+    int pox = player.offset.x;
+    int poy = player.offset.y;
+    int poz = player.offset.z;
+
+    // Check if Player collided with ground
+    if (poy + shape.boundsMin.y < 0)
+    {
+        if (logging)
+            std::cout << "Collision with ground at " << pox << ", " << poy << ", " << poz << std::endl;
+        return true;
+    }
+
+    // Check for collision with static block
+    if (area.overlaps(shape, player.offset))
+    {
+        if (logging)
+            std::cout << "Collision with block at " << pox << ", " << poy << ", " << poz << std::endl;
+        return true;
+    }
+
+    return false;
+}
+
+bool GameCore::detectHorizontalCollision(const Shape &shape)
+{
+    int pox = player.offset.x;
+    int poz = player.offset.z;
+
+    // Check for collision with static block
+    if (area.overlaps(shape, player.offset))
+        return true;
+    
+    // Check for collision with side border (relevant for rotations)
+    if (pox + shape.boundsMin.x < 0 || pox + shape.boundsMax.x >= area.WIDTH ||
+            poz + shape.boundsMin.z < 0 || poz + shape.boundsMax.z >= area.WIDTH)
+        return true;
+
+    return false;
+}
+
+#endif
@@ -12,10 +12,13 @@
 #include "game_logic.hpp"
 #include "camera.hpp"
 #include "block.hpp"
+#include "bot.hpp"
+#include "frame_uniforms.hpp"
 
 #include <iostream>
 #include <cmath>
 #include <map>
+#include <memory>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H  
@@ -23,10 +26,13 @@
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char *path);
+unsigned int loadTextureArray(const std::vector<std::string> &paths);
 
 void initFreeType();
-void renderText(Shader &shader, std::string text, float x, float y, float scale, glm::vec3 color);
+void renderText(Shader &shader, const UniformHandle<glm::vec3> &colorUniform, std::string text, float x, float y, float scale, glm::vec3 color);
+
+void onGameEvent(const GameEvent &event);
+void updateHudText();
 
 
 const unsigned int SCREEN_WIDTH  = 800;
@@ -39,6 +45,14 @@ float lastFrameTime = 0.0f;
 
 Game game;
 Camera camera;
+GameStats stats;
+std::unique_ptr<Bot> bot; // created the first time it is enabled, so its threads only start when needed
+bool botEnabled = false; // toggled with B, the Bot then plays instead of the keyboard
+
+// HUD text is only rebuilt when score, speed or disco mode change
+std::string scoreText;
+std::string speedText;
+bool hudDirty = true;
 
 struct Character
 {
@@ -50,9 +64,12 @@ struct Character
 std::map<char, Character> characters;
 unsigned int fVAO, fVBO;
 
-int main()
+int main(int argc, char **argv)
 {
-    srand(time(nullptr));
+    // Optional seed argument replays the same sequence of pieces
+    uint64_t seed = argc > 1 ? std::stoull(argv[1]) : time(nullptr);
+    game.pieces.reset(seed);
+    std::cout << "Seed: " << seed << std::endl;
 
     // glfw: initialize and configure
     glfwInit(); // NOTE: generating any buffers before this causes a segmentation fault, generally when initializing objects in global scope
@@ -90,6 +107,7 @@ int main()
 
     // ------------------------------------------------------------------------------------------------
     game.init();
+    game.subscribe(onGameEvent);
     camera = Camera(game.area);
     block = Block("resources/objects/block/white-block.obj");
 
@@ -97,6 +115,10 @@ int main()
     Shader shader("shaders/my_shader.vert", "shaders/my_shader.frag");
     Shader lightSourceShader("shaders/my_shader.vert", "shaders/light_source.frag");
     Shader textShader("shaders/text.vert", "shaders/text.frag");
+
+    // Uniforms set every frame, resolved once (camera and lights are in frameUniforms)
+    UniformHandle<glm::mat4> lightSourceModelUniform = lightSourceShader.getUniform<glm::mat4>("model");
+    UniformHandle<glm::vec3> textColorUniform = textShader.getUniform<glm::vec3>("textColor");
     
     initFreeType();
     glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(currScrWidth), 0.0f, static_cast<float>(currScrHeight));
@@ -105,42 +127,38 @@ int main()
 
     glm::vec3 areaCenter = game.area.getCenter();
 
+    // Material textures stay bound to these units, shininess comes from the MaterialTable (see initMaterials)
+    lightSourceShader.use();
+    lightSourceShader.setInt("material.diffuse", 0); // 0 == GL_TEXTURE0
     shader.use();
     shader.setInt("material.diffuse", 0); // 0 == GL_TEXTURE0
     shader.setInt("material.specular", 1); // 1 == GL_TEXTURE1
-    shader.setFloat("material.shininess", 100.0f);
-    shader.setVec3("dirLight.direction", 0.2f, 1.0f, 0.2f);
-    shader.setVec3("dirLight.ambient", 0.2f, 0.2f, 0.2f);
-    shader.setVec3("dirLight.diffuse", 0.8f, 0.8f, 0.8f);
-    shader.setVec3("dirLight.specular", 0.9f, 0.9f, 0.9f);
-
-    shader.setVec3("pointLights[0].ambient", 0.0f, 0.0f, 0.0f);
-    shader.setVec3("pointLights[0].diffuse", 0.6f, 0.6f, 0.6f);
-    shader.setVec3("pointLights[0].specular", 0.5f, 0.5f, 0.5f);
-    shader.setFloat("pointLights[0].constant", 1.0f);
-    shader.setFloat("pointLights[0].linear", 0.045);
-    shader.setFloat("pointLights[0].quadratic", 0.0075);
-
-    shader.setVec3("pointLights[1].ambient", 0.0f, 0.0f, 0.0f);
-    shader.setVec3("pointLights[1].diffuse", 1.0f, 0.0f, 0.0f);
-    shader.setVec3("pointLights[1].specular", 0.5f, 0.0f, 0.0f);
-    shader.setFloat("pointLights[1].constant", 1.0f);
-    shader.setFloat("pointLights[1].linear", 0.045);
-    shader.setFloat("pointLights[1].quadratic", 0.0075);
-
-    shader.setVec3("pointLights[2].ambient", 0.0f, 0.0f, 0.0f);
-    shader.setVec3("pointLights[2].diffuse", 0.0f, 1.0f, 0.0f);
-    shader.setVec3("pointLights[2].specular", 0.0f, 0.5f, 0.0f);
-    shader.setFloat("pointLights[2].constant", 1.0f);
-    shader.setFloat("pointLights[2].linear", 0.045);
-    shader.setFloat("pointLights[2].quadratic", 0.0075);
-
-    shader.setVec3("pointLights[3].ambient", 0.0f, 0.0f, 0.0f);
-    shader.setVec3("pointLights[3].diffuse", 0.0f, 0.0f, 1.0f);
-    shader.setVec3("pointLights[3].specular", 0.0f, 0.0f, 0.5f);
-    shader.setFloat("pointLights[3].constant", 1.0f);
-    shader.setFloat("pointLights[3].linear", 0.045);
-    shader.setFloat("pointLights[3].quadratic", 0.0075);
+
+    // Camera and lights of both programs, uploaded once per frame
+    FrameUniforms frameUniforms;
+    frameUniforms.init();
+    DirectionalLightBlock &dirLight = frameUniforms.lights.dirLight;
+    dirLight.direction = glm::vec3(0.2f, 1.0f, 0.2f);
+    dirLight.ambient = glm::vec3(0.2f, 0.2f, 0.2f);
+    dirLight.diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+    dirLight.specular = glm::vec3(0.9f, 0.9f, 0.9f);
+
+    const glm::vec3 pointLightColors[NR_POINT_LIGHTS] = {
+        glm::vec3(0.6f, 0.6f, 0.6f),
+        glm::vec3(1.0f, 0.0f, 0.0f),
+        glm::vec3(0.0f, 1.0f, 0.0f),
+        glm::vec3(0.0f, 0.0f, 1.0f),
+    };
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+    {
+        PointLightBlock &pointLight = frameUniforms.lights.pointLights[i];
+        pointLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+        pointLight.diffuse = pointLightColors[i];
+        pointLight.specular = i == 0 ? glm::vec3(0.5f, 0.5f, 0.5f) : pointLightColors[i] * 0.5f;
+        pointLight.constant = 1.0f;
+        pointLight.linear = 0.045f;
+        pointLight.quadratic = 0.0075f;
+    }
 
     glm::vec3 bgColor = glm::vec3(0.5f, 0.5f, 0.5f);
     
@@ -178,10 +196,9 @@ int main()
         
         
 
-        shader.use();
-        shader.setVec3("viewPos", camera.getPosition());
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
+        frameUniforms.frame.view = view;
+        frameUniforms.frame.projection = projection;
+        frameUniforms.frame.viewPos = camera.getPosition();
 
         if (game.discoMode || game.discoInitiated)
         {
@@ -192,13 +209,13 @@ int main()
                 discoTimeStamp = glfwGetTime();
                 std::cout << discoTimeStamp << std::endl;
 
+                dirLight.diffuse = glm::vec3(0.0f, 0.0f, 0.0f);
+                dirLight.specular = glm::vec3(0.0f, 0.0f, 0.0f);
                 shader.use();
-                shader.setVec3("dirLight.diffuse", 0.0f, 0.0f, 0.0f);
-                shader.setVec3("dirLight.specular", 0.0f, 0.0f, 0.0f);
                 shader.setBool("discoMode", true);
 
-                for (int i = 0; i < AREA_HEIGHT && game.area.countPerRow[i]; i++)
-                    if (game.area.countPerRow[i] > 0)
+                for (int i = 0; i < Area::HEIGHT && game.area.getRowCount(i); i++)
+                    if (game.area.getRowCount(i) > 0)
                         discoOffset = i;
             }
             
@@ -210,24 +227,27 @@ int main()
 
             float rotSpeed = 1 / 4.0f;
             glm::vec3 pointLightPositions[] = {
-                glm::vec3(areaCenter.x + AREA_WIDTH * sin(glfwGetTime() * rotSpeed), areaCenter.y + sin(glfwGetTime()), areaCenter.z + AREA_WIDTH * cos(glfwGetTime() * rotSpeed)),
-                glm::vec3(areaCenter.x + AREA_WIDTH * sin(glfwGetTime() * rotSpeed), discoOffset + 3 * sin(glfwGetTime()), areaCenter.z + AREA_WIDTH * cos(glfwGetTime() * rotSpeed)),
-                glm::vec3(areaCenter.x + AREA_WIDTH * sin(glfwGetTime() * rotSpeed + 2 * M_PI / 3), discoOffset + 3 * sin(glfwGetTime() * M_PI_2), areaCenter.z + AREA_WIDTH * cos(glfwGetTime() * rotSpeed + 2 * M_PI / 3)),
-                glm::vec3(areaCenter.x + AREA_WIDTH * sin(glfwGetTime() * rotSpeed + 4 * M_PI / 3), discoOffset + 3 * sin(glfwGetTime() * M_PI), areaCenter.z + AREA_WIDTH * cos(glfwGetTime() * rotSpeed + 4 * M_PI / 3)),
+                glm::vec3(areaCenter.x + Area::WIDTH * sin(glfwGetTime() * rotSpeed), areaCenter.y + sin(glfwGetTime()), areaCenter.z + Area::WIDTH * cos(glfwGetTime() * rotSpeed)),
+                glm::vec3(areaCenter.x + Area::WIDTH * sin(glfwGetTime() * rotSpeed), discoOffset + 3 * sin(glfwGetTime()), areaCenter.z + Area::WIDTH * cos(glfwGetTime() * rotSpeed)),
+                glm::vec3(areaCenter.x + Area::WIDTH * sin(glfwGetTime() * rotSpeed + 2 * M_PI / 3), discoOffset + 3 * sin(glfwGetTime() * M_PI_2), areaCenter.z + Area::WIDTH * cos(glfwGetTime() * rotSpeed + 2 * M_PI / 3)),
+                glm::vec3(areaCenter.x + Area::WIDTH * sin(glfwGetTime() * rotSpeed + 4 * M_PI / 3), discoOffset + 3 * sin(glfwGetTime() * M_PI), areaCenter.z + Area::WIDTH * cos(glfwGetTime() * rotSpeed + 4 * M_PI / 3)),
             };
-            shader.use();
-            for (int i = 1; i < sizeof(pointLightPositions) / sizeof(glm::vec3); i++)
-                shader.setVec3("pointLights[" + std::to_string(i) + "].position", pointLightPositions[i]);
+            for (int i = 1; i < NR_POINT_LIGHTS; i++)
+                frameUniforms.lights.pointLights[i].position = pointLightPositions[i];
+        }
+
+        frameUniforms.upload();
+
+        if (game.discoMode)
+        {
             lightSourceShader.use();
-            lightSourceShader.setMat4("projection", projection);
-            lightSourceShader.setMat4("view", view);
-            for (int i = 1; i < sizeof(pointLightPositions) / sizeof(glm::vec3); i++)
+            for (int i = 1; i < NR_POINT_LIGHTS; i++)
             {
                 glm::mat4 model(1.0f);
-                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::translate(model, frameUniforms.lights.pointLights[i].position);
                 model = glm::scale(model, glm::vec3(0.4f));
-                lightSourceShader.setMat4("model", model);
-                block.material = materials[i + 8];
+                lightSourceModelUniform.set(model);
+                block.materialIndex = i + 8;
                 block.draw();
             }
 
@@ -235,32 +255,32 @@ int main()
             if (glfwGetTime() - discoTimeStamp > 10.0)
             {
                 game.discoMode = false;
+                hudDirty = true;
 
                 bgColor = glm::vec3(0.5f, 0.5f, 0.5f);
 
+                dirLight.diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+                dirLight.specular = glm::vec3(0.3f, 0.3f, 0.3f);
                 shader.use();
-                shader.setVec3("dirLight.diffuse", 0.8f, 0.8f, 0.8f);
-                shader.setVec3("dirLight.specular", 0.3f, 0.3f, 0.3f);
                 shader.setBool("discoMode", false);
             }
         }
-        game.processLogic();
+        game.step(std::min(deltaTime, 0.25f)); // don't try to catch up on long stalls (e.g. window being dragged)
         game.render(shader, camera.getPosition());
 
         // Render text
+        if (hudDirty)
+            updateHudText();
         textShader.use();
-        renderText(textShader, "Score: " + std::to_string(game.score) + (game.discoMode ? "(x3)" : ""), 10.0f, currScrHeight - 48.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-        std::stringstream stream;
-        stream << std::fixed << std::setprecision(1) << game.speed;
-        std::string speed = stream.str();
-        renderText(textShader, "Speed: " + speed, 10.0f, currScrHeight - 72.0f, 0.6f, glm::vec3(0.0f, 0.0f, 0.0f));
+        renderText(textShader, textColorUniform, scoreText, 10.0f, currScrHeight - 48.0f, 1.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+        renderText(textShader, textColorUniform, speedText, 10.0f, currScrHeight - 72.0f, 0.6f, glm::vec3(0.0f, 0.0f, 0.0f));
 
         if (game.state == OVER)
         {
             bgColor = glm::vec3(0.8f, 0.0f, 0.0f);
-            renderText(textShader, "Game Over", 10.0f, 24.0f, 2.0f, glm::vec3(1.0f, 1.0f, 1.0f));
-            shader.setVec3("dirLight.ambient", 0.05f, 0.0f, 0.0f);
-            shader.setVec3("dirLight.diffuse", 0.8f, 0.0f, 0.0f);
+            renderText(textShader, textColorUniform, "Game Over", 10.0f, 24.0f, 2.0f, glm::vec3(1.0f, 1.0f, 1.0f));
+            dirLight.ambient = glm::vec3(0.05f, 0.0f, 0.0f);
+            dirLight.diffuse = glm::vec3(0.8f, 0.0f, 0.0f);
         }
 
         // Check and call events and swap buffers
@@ -272,6 +292,7 @@ int main()
         
     shader.del();
     block.del();
+    frameUniforms.del();
     //whiteBlock.del();
 
     
@@ -287,7 +308,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     currScrHeight = height;
 }
 
-bool pressedT = false, pressedR = false;
+bool pressedT = false, pressedR = false, pressedB = false;
 bool spacePressed = false;
 void processInput(GLFWwindow* window)
 {
@@ -314,6 +335,32 @@ void processInput(GLFWwindow* window)
         pressedT = false; */
 
 
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+    {
+        if (game.state == ACTIVE) game.setState(PAUSED);
+        else if (game.state == PAUSED) game.setState(ACTIVE);
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !pressedB)
+    {
+        pressedB = true;
+        botEnabled = !botEnabled;
+        if (botEnabled && !bot)
+            bot = std::make_unique<Bot>(game, BotWeights(), std::thread::hardware_concurrency());
+        if (botEnabled)
+            bot->plan();
+        else
+            game.transform(NONE);
+    }
+    else if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE)
+        pressedB = false;
+
+    if (botEnabled)
+    {
+        bot->update();
+        return;
+    }
+
     // Handle block control
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_A) == GLFW_RELEASE
             && glfwGetKey(window, GLFW_KEY_W) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_S) == GLFW_RELEASE
@@ -367,48 +414,81 @@ void processInput(GLFWwindow* window)
     }
     else if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE)
         spacePressed = false;
+}
 
-    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
-    {
-        if (game.state == ACTIVE) game.state = PAUSED;
-        else if (game.state == PAUSED) game.state = ACTIVE;
-    }
+void onGameEvent(const GameEvent &event)
+{
+    stats.onEvent(event);
+
+    if (event.type == PIECE_LOCKED || event.type == ROWS_CLEARED || event.type == SPEED_CHANGED || event.type == SNAPSHOT_RESTORED)
+        hudDirty = true;
+
+    if (event.type == STATE_CHANGED && event.value == OVER)
+        std::cout << "Pieces: " << stats.piecesLocked << "\tRows cleared: " << stats.rowsCleared
+            << "\tMoves: " << stats.moves << "\tRotations: " << stats.rotations << std::endl;
 }
 
-unsigned int loadTexture(const char *path)
+void updateHudText()
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+    scoreText = "Score: " + std::to_string(game.score) + (game.discoMode ? "(x3)" : "");
+
+    std::stringstream stream;
+    stream << std::fixed << std::setprecision(1) << game.speed;
+    speedText = "Speed: " + stream.str();
+
+    hudDirty = false;
+}
 
-    int width, height, numComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &numComponents, 0);
-    if (data)
+// Load images into the layers of a texture array. Layers all have the size of the largest image, smaller ones are scaled up
+// (nearest neighbour, they are mostly flat colors); an empty path or an image that fails to load gives a black layer
+unsigned int loadTextureArray(const std::vector<std::string> &paths)
+{
+    std::vector<unsigned char *> images(paths.size(), nullptr);
+    std::vector<glm::ivec2> sizes(paths.size(), glm::ivec2(0, 0));
+    int width = 1, height = 1;
+    for (size_t i = 0; i < paths.size(); i++)
     {
-        GLenum format;
-        if (numComponents == 1)
-            format = GL_RED;
-        else if (numComponents == 3)
-            format = GL_RGB;
-        else if (numComponents == 4)
-            format = GL_RGBA;
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        if (paths[i].empty())
+            continue;
 
-        stbi_image_free(data);
+        int numComponents;
+        images[i] = stbi_load(paths[i].c_str(), &sizes[i].x, &sizes[i].y, &numComponents, 4); // always RGBA
+        if (!images[i])
+        {
+            std::cout << "Texture failed to load at path: " << paths[i] << std::endl;
+            continue;
+        }
+        width = std::max(width, sizes[i].x);
+        height = std::max(height, sizes[i].y);
     }
-    else
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, paths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    std::vector<unsigned char> layer(width * height * 4);
+    for (size_t i = 0; i < paths.size(); i++)
     {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
+        std::fill(layer.begin(), layer.end(), 0);
+        if (images[i])
+        {
+            for (int y = 0; y < height; y++)
+                for (int x = 0; x < width; x++)
+                {
+                    int source = (y * sizes[i].y / height) * sizes[i].x + x * sizes[i].x / width;
+                    std::copy(images[i] + source * 4, images[i] + source * 4 + 4, &layer[(y * width + x) * 4]);
+                }
+            stbi_image_free(images[i]);
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, &layer[0]);
     }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     return textureID;
 }
@@ -487,11 +567,11 @@ void initFreeType()
     glBindVertexArray(0);
 }
 
-void renderText(Shader &shader, std::string text, float x, float y, float scale, glm::vec3 color)
+void renderText(Shader &shader, const UniformHandle<glm::vec3> &colorUniform, std::string text, float x, float y, float scale, glm::vec3 color)
 {
     // activate corresponding render state	
     shader.use();
-    glUniform3f(glGetUniformLocation(shader.ID, "textColor"), color.x, color.y, color.z);
+    colorUniform.set(color);
     glActiveTexture(GL_TEXTURE0);
     glBindVertexArray(fVAO);
 
@@ -0,0 +1,148 @@
+#ifndef PIECE_SOURCE_H
+#define PIECE_SOURCE_H
+
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+#include "shape.hpp"
+
+#define PIECE_QUEUE_SIZE 8
+
+
+// xoshiro256** generator, small and fast enough to be copied along with game state
+class Random
+{
+    public:
+        Random(uint64_t seed = 0) { setSeed(seed); }
+
+        void setSeed(uint64_t seed)
+        {
+            // Expand seed with splitmix64 so that similar seeds give unrelated streams
+            for (int i = 0; i < 4; i++)
+            {
+                seed += 0x9E3779B97F4A7C15ull;
+                uint64_t z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                state[i] = z ^ (z >> 31);
+            }
+        }
+
+        uint64_t next()
+        {
+            uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+            uint64_t t = state[1] << 17;
+
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = std::rotl(state[3], 45);
+
+            return result;
+        }
+
+        // Uniform integer in [0, n)
+        int nextInt(int n) { return (int) (((next() >> 32) * (uint64_t) n) >> 32); }
+
+        // Uniform double in [0, 1)
+        double nextDouble() { return (next() >> 11) * 0x1.0p-53; }
+
+    private:
+        uint64_t state[4];
+};
+
+
+// PIECE SOURCE
+
+enum PieceDistribution {
+    DIST_UNIFORM, // every piece is drawn independently
+    DIST_BAG      // every SHAPE_COUNT pieces contain each Shape exactly once
+};
+
+struct Piece
+{
+    int shapeIndex;
+    int orientation; // index into shapeOrientations[shapeIndex]
+};
+
+// Reproducible stream of pieces with a queue of upcoming pieces, which can be inspected before they are spawned
+class PieceSource
+{
+    public:
+        PieceSource(uint64_t seed = 0, PieceDistribution distribution = DIST_UNIFORM) { reset(seed, distribution); }
+
+        void reset(uint64_t seed, PieceDistribution distribution = DIST_UNIFORM);
+
+        Piece next();
+        const Piece &peek(int i) const { return queue[(queueStart + i) % PIECE_QUEUE_SIZE]; } // i < PIECE_QUEUE_SIZE
+        PieceDistribution getDistribution() const { return distribution; }
+
+    private:
+        Random random;
+        PieceDistribution distribution;
+
+        Piece queue[PIECE_QUEUE_SIZE]; // ring buffer, always full
+        int queueStart;
+
+        int bag[SHAPE_COUNT];
+        int bagSize;
+
+        Piece generate();
+};
+
+void PieceSource::reset(uint64_t seed, PieceDistribution distribution)
+{
+    random.setSeed(seed);
+    this->distribution = distribution;
+    bagSize = 0;
+
+    queueStart = 0;
+    for (int i = 0; i < PIECE_QUEUE_SIZE; i++)
+        queue[i] = generate();
+}
+
+Piece PieceSource::next()
+{
+    Piece piece = queue[queueStart];
+    queue[queueStart] = generate();
+    queueStart = (queueStart + 1) % PIECE_QUEUE_SIZE;
+
+    return piece;
+}
+
+Piece PieceSource::generate()
+{
+    Piece piece;
+    if (distribution == DIST_BAG)
+    {
+        // Refill and shuffle (Fisher-Yates) once the bag is empty
+        if (bagSize == 0)
+        {
+            for (int i = 0; i < SHAPE_COUNT; i++)
+                bag[i] = i;
+            for (int i = SHAPE_COUNT - 1; i > 0; i--)
+                std::swap(bag[i], bag[random.nextInt(i + 1)]);
+            bagSize = SHAPE_COUNT;
+        }
+        piece.shapeIndex = bag[--bagSize];
+    }
+    else
+        piece.shapeIndex = random.nextInt(SHAPE_COUNT);
+
+    // Randomize initial rotation
+    const ShapeOrientations &orientations = shapeOrientations[piece.shapeIndex];
+    piece.orientation = 0;
+    for (int a = AXIS_X; a <= AXIS_Z; a++)
+    {
+        int rotations = random.nextInt(4);
+        for (int i = 0; i < rotations; i++)
+            piece.orientation = orientations.next[piece.orientation][a][getRotationIndex(ROT_CW)];
+    }
+
+    return piece;
+}
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "shape.hpp"
+#include "area.hpp"
+#include "game_core.hpp"
+#include "constants.hpp"
+
+
+// Final resting position of a piece
+struct Placement
+{
+    int orientation;   // index into shapeOrientations[shapeIndex]
+    glm::ivec3 offset; // Player offset after landing
+};
+
+// Upper bound on the number of placements of one piece in a W x W Area
+#define MAX_PLACEMENTS(W) (MAX_ORIENTATIONS * (W) * (W))
+
+// Every distinct placement of the Player's Shape reachable by dropping it straight down from the Player's current height.
+// Orientations that only differ by a translation are listed once, placements outside the Area borders or
+// overlapping static blocks at the starting height are skipped. placements is cleared first, so it can be reused between calls.
+template <int W, int H>
+void getPlacements(const BasicArea<W, H> &area, const Player &player, std::vector<Placement> &placements)
+{
+    placements.clear();
+
+    const ShapeOrientations &orientations = shapeOrientations[player.shapeIndex];
+    for (int u = 0; u < orientations.uniqueCount; u++)
+    {
+        int o = orientations.unique[u];
+        const Shape &shape = orientations.orientations[o];
+
+        // Same border rules as GameCore::detectHorizontalCollision
+        for (int x = -shape.boundsMin.x; x + shape.boundsMax.x < W; x++)
+            for (int z = -shape.boundsMin.z; z + shape.boundsMax.z < W; z++)
+            {
+                glm::ivec3 offset(x, player.offset.y, z);
+                if (area.collides(shape, offset))
+                    continue;
+
+                offset.y -= area.getDropDistance(shape, offset);
+                placements.push_back({ o, offset });
+            }
+    }
+}
+
+
+// INPUT PLANNING
+
+// One input for GameCore: a transform() call, or for NONE a setRotationAxis() call
+struct Input
+{
+    Transformation transformation;
+    Axis axis; // new rotation axis, only for NONE
+};
+
+// Breadth-first search over (orientation, rotation axis, x, z) at the Player's current height, with the rules of
+// GameCore::transform: moves and rotations are refused by the same border and static block checks as in the game.
+// Gives the shortest input sequence to a placement, and the placements that can really be reached (e.g. not
+// below an overhang, or behind a wall the piece can't pass). Scratch memory is kept between searches
+template <int W, int H>
+class PathPlanner
+{
+    public:
+        void search(const BasicArea<W, H> &, const Player &);
+
+        // Inputs leading from the searched start to target (followed by a drop), false if it can't be reached
+        bool getInputs(const Placement &target, std::vector<Input> &inputs) const;
+
+        // Like getPlacements(), but only the placements that can be reached with inputs from the Player's position
+        void getReachablePlacements(const BasicArea<W, H> &, const Player &, std::vector<Placement> &placements);
+
+    private:
+        static const int RANGE = W + SHAPE_WIDTH - 1; // offsets from -(SHAPE_WIDTH - 1) to W - 1
+        static const int STATES = MAX_ORIENTATIONS * 3 * RANGE * RANGE;
+
+        int shapeIndex = -1;
+        glm::ivec3 start;
+        bool open = false; // nothing can block the piece, only rotations at the start were searched
+        std::vector<int> distance;  // per state, -1 if not reached
+        std::vector<int> previous;  // per state
+        std::vector<Input> via;     // per state, input that led to it
+        std::vector<int> queue;     // reached states in BFS order
+        std::vector<bool> listed;   // per (canonical orientation, x, z), for getReachablePlacements()
+        std::vector<signed char> fits; // per (orientation, x, z): 1 if inside the borders and free of static blocks, -1 if not checked yet
+
+        static int getState(int orientation, int axis, int x, int z) { return ((orientation * 3 + axis) * RANGE + x + SHAPE_WIDTH - 1) * RANGE + z + SHAPE_WIDTH - 1; }
+        static bool isInside(const Shape &shape, int x, int z) { return x + shape.boundsMin.x >= 0 && x + shape.boundsMax.x < W && z + shape.boundsMin.z >= 0 && z + shape.boundsMax.z < W; }
+        static bool isOpen(const BasicArea<W, H> &, const Player &);
+};
+
+// Above the stack nothing can block a move or rotation; if the piece's 3x3x3 box is inside the borders, it can take
+// every orientation where it is and then reach any placement inside the borders
+template <int W, int H>
+bool PathPlanner<W, H>::isOpen(const BasicArea<W, H> &area, const Player &player)
+{
+    int stackHeight = *std::max_element(area.heights, area.heights + W * W);
+    return player.offset.y >= stackHeight && player.offset.x >= 0 && player.offset.x + SHAPE_WIDTH <= W
+        && player.offset.z >= 0 && player.offset.z + SHAPE_WIDTH <= W;
+}
+
+template <int W, int H>
+void PathPlanner<W, H>::search(const BasicArea<W, H> &area, const Player &player)
+{
+    distance.assign(STATES, -1);
+    fits.assign(MAX_ORIENTATIONS * RANGE * RANGE, -1);
+    previous.resize(STATES);
+    via.resize(STATES);
+    queue.clear();
+
+    shapeIndex = player.shapeIndex;
+    start = player.offset;
+    open = isOpen(area, player);
+    const ShapeOrientations &orientations = shapeOrientations[shapeIndex];
+    const int y = player.offset.y;
+
+    int startState = getState(player.orientation, player.rotationAxis, start.x, start.z);
+    distance[startState] = 0;
+    queue.push_back(startState);
+
+    const Transformation moves[] = { TRANS_LEFT, TRANS_RIGHT, TRANS_FORWARD, TRANS_BACKWARD };
+    const int dx[] = { 1, -1, 0, 0 };
+    const int dz[] = { 0, 0, 1, -1 };
+    const Transformation rotations[] = { ROT_CW, ROT_CCW };
+
+    for (size_t q = 0; q < queue.size(); q++)
+    {
+        int state = queue[q];
+        int z = state % RANGE - (SHAPE_WIDTH - 1);
+        int x = state / RANGE % RANGE - (SHAPE_WIDTH - 1);
+        int axis = state / (RANGE * RANGE) % 3;
+        int o = state / (RANGE * RANGE * 3);
+        const Shape &shape = orientations.orientations[o];
+
+        // The rotation axis doesn't matter for collisions, so each position is only checked once
+        auto fitsAt = [&](int orientation, int x, int z) {
+            signed char &result = fits[(orientation * RANGE + x + SHAPE_WIDTH - 1) * RANGE + z + SHAPE_WIDTH - 1];
+            if (result < 0)
+            {
+                const Shape &shape = orientations.orientations[orientation];
+                result = isInside(shape, x, z) && !area.overlaps(shape, glm::ivec3(x, y, z));
+            }
+            return result == 1;
+        };
+
+        auto visit = [&](int next, Input input) {
+            if (distance[next] >= 0)
+                return;
+            distance[next] = distance[state] + 1;
+            previous[next] = state;
+            via[next] = input;
+            queue.push_back(next);
+        };
+
+        // Moves are refused at the border or when blocked by static blocks
+        for (int m = 0; m < 4 && !open; m++)
+            if (isInside(shape, x + dx[m], z + dz[m]) && fitsAt(o, x + dx[m], z + dz[m]))
+                visit(getState(o, axis, x + dx[m], z + dz[m]), { moves[m], AXIS_X });
+
+        // Rotations around the current axis (see GameCore::detectHorizontalCollision)
+        for (int r = 0; r < 2; r++)
+        {
+            int n = orientations.next[o][axis][getRotationIndex(rotations[r])];
+            if (fitsAt(n, x, z))
+                visit(getState(n, axis, x, z), { rotations[r], AXIS_X });
+        }
+
+        for (int a = AXIS_X; a <= AXIS_Z; a++)
+            if (a != axis)
+                visit(getState(o, a, x, z), { NONE, (Axis) a });
+    }
+}
+
+template <int W, int H>
+bool PathPlanner<W, H>::getInputs(const Placement &target, std::vector<Input> &inputs) const
+{
+    inputs.clear();
+    if (shapeIndex < 0)
+        return false;
+
+    // Any orientation with the same cells will do, shifted so its cells end up in the same columns
+    const ShapeOrientations &orientations = shapeOrientations[shapeIndex];
+    const Shape &targetShape = orientations.orientations[target.orientation];
+    int best = -1;
+    int bestCost = 0;
+    glm::ivec2 bestMove(0, 0); // only in the open
+    for (int o = 0; o < orientations.count; o++)
+    {
+        if (orientations.canonical[o] != orientations.canonical[target.orientation])
+            continue;
+
+        const Shape &shape = orientations.orientations[o];
+        int x = target.offset.x + targetShape.boundsMin.x - shape.boundsMin.x;
+        int z = target.offset.z + targetShape.boundsMin.z - shape.boundsMin.z;
+        if (!isInside(shape, x, z))
+            continue;
+
+        // In the open, rotate at the start and then move straight there
+        for (int a = AXIS_X; a <= AXIS_Z; a++)
+        {
+            int state = open ? getState(o, a, start.x, start.z) : getState(o, a, x, z);
+            int cost = distance[state] + (open ? std::abs(x - start.x) + std::abs(z - start.z) : 0);
+            if (distance[state] >= 0 && (best < 0 || cost < bestCost))
+            {
+                best = state;
+                bestCost = cost;
+                if (open)
+                    bestMove = glm::ivec2(x - start.x, z - start.z);
+            }
+        }
+    }
+    if (best < 0)
+        return false;
+
+    for (int state = best; distance[state] > 0; state = previous[state])
+        inputs.push_back(via[state]);
+    std::reverse(inputs.begin(), inputs.end());
+
+    for (int i = 0; i < std::abs(bestMove.x); i++)
+        inputs.push_back({ bestMove.x > 0 ? TRANS_LEFT : TRANS_RIGHT, AXIS_X });
+    for (int i = 0; i < std::abs(bestMove.y); i++)
+        inputs.push_back({ bestMove.y > 0 ? TRANS_FORWARD : TRANS_BACKWARD, AXIS_X });
+
+    return true;
+}
+
+template <int W, int H>
+void PathPlanner<W, H>::getReachablePlacements(const BasicArea<W, H> &area, const Player &player, std::vector<Placement> &placements)
+{
+    if (isOpen(area, player))
+    {
+        getPlacements(area, player, placements);
+        return;
+    }
+
+    search(area, player);
+
+    placements.clear();
+    listed.assign(MAX_ORIENTATIONS * RANGE * RANGE, false);
+
+    const ShapeOrientations &orientations = shapeOrientations[shapeIndex];
+    for (int state : queue)
+    {
+        int z = state % RANGE - (SHAPE_WIDTH - 1);
+        int x = state / RANGE % RANGE - (SHAPE_WIDTH - 1);
+        int o = state / (RANGE * RANGE * 3);
+
+        // Listed as the canonical orientation, like getPlacements()
+        int c = orientations.canonical[o];
+        const Shape &shape = orientations.orientations[o];
+        if (player.offset.y + shape.boundsMin.y < 0)
+            continue; // rotated into the ground, it would lock right away
+        const Shape &canonical = orientations.orientations[c];
+        glm::ivec3 offset(x + shape.boundsMin.x - canonical.boundsMin.x,
+                          player.offset.y + shape.boundsMin.y - canonical.boundsMin.y,
+                          z + shape.boundsMin.z - canonical.boundsMin.z);
+
+        int key = (c * RANGE + offset.x + SHAPE_WIDTH - 1) * RANGE + offset.z + SHAPE_WIDTH - 1;
+        if (listed[key])
+            continue;
+        listed[key] = true;
+
+        offset.y -= area.getDropDistance(canonical, offset);
+        placements.push_back({ c, offset });
+    }
+}
+
+#endif
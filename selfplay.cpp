@@ -0,0 +1,122 @@
+// Headless batch self-play: runs many Bot games in parallel and reports throughput and results
+//
+// usage: selfplay [games] [threads] [first seed] [max pieces per game] [lookahead] [beam width]
+
+#include "game_core.hpp"
+#include "bot.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+struct GameResult
+{
+    uint64_t seed;
+    int pieces;
+    int rowsCleared;
+    int score;
+    double speed;
+    long long searchNodes;
+    double searchSeconds;
+};
+
+// Everything a game touches lives on this stack frame (the Shape tables it reads are constexpr)
+GameResult playGame(uint64_t seed, int maxPieces, int lookahead, int beamWidth)
+{
+    GameCore game;
+    game.logging = false;
+    game.pieces.reset(seed);
+
+    GameStats stats;
+    game.subscribe([&stats](const GameEvent &event) { stats.onEvent(event); });
+
+    Bot bot(game);
+    bot.actionsPerUpdate = 1 << 16; // place every piece right after it spawns
+    bot.lookahead = lookahead;
+    bot.getSearch().width = beamWidth;
+
+    while (game.state == ACTIVE && stats.piecesLocked < maxPieces)
+    {
+        bot.update();
+        game.step(1.0 / game.tickRate);
+    }
+
+    return { seed, stats.piecesLocked, stats.rowsCleared, game.score, game.speed, bot.getSearch().nodes, bot.getSearch().seconds };
+}
+
+template <typename T>
+void printDistribution(const std::string &name, std::vector<T> values)
+{
+    std::sort(values.begin(), values.end());
+    double mean = 0.0;
+    for (T value : values)
+        mean += value;
+    mean /= values.size();
+
+    auto percentile = [&values](double p) { return values[(size_t) (p * (values.size() - 1))]; };
+    std::cout << std::setw(8) << name
+              << "  min " << values.front()
+              << "  p10 " << percentile(0.1)
+              << "  median " << percentile(0.5)
+              << "  p90 " << percentile(0.9)
+              << "  max " << values.back()
+              << "  mean " << mean << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    int games = argc > 1 ? std::stoi(argv[1]) : 64;
+    int threads = argc > 2 ? std::stoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    uint64_t firstSeed = argc > 3 ? std::stoull(argv[3]) : 1;
+    int maxPieces = argc > 4 ? std::stoi(argv[4]) : 2000;
+    int lookahead = argc > 5 ? std::stoi(argv[5]) : 1;
+    int beamWidth = argc > 6 ? std::stoi(argv[6]) : 16;
+    if (games < 1 || threads < 1 || lookahead < 1 || beamWidth < 1)
+    {
+        std::cout << "usage: selfplay [games] [threads] [first seed] [max pieces per game] [lookahead] [beam width]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Playing " << games << " games on " << threads << " threads (seeds " << firstSeed << ".." << firstSeed + games - 1
+              << ", at most " << maxPieces << " pieces each, lookahead " << lookahead << ")" << std::endl;
+
+    // Every game writes only its own result slot
+    std::vector<GameResult> results(games);
+    ThreadPool pool(threads);
+
+    auto start = std::chrono::steady_clock::now();
+    pool.parallelFor(games, [&](int i, int) { results[i] = playGame(firstSeed + i, maxPieces, lookahead, beamWidth); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long pieces = 0;
+    long long searchNodes = 0;
+    double searchSeconds = 0.0;
+    std::vector<int> scores;
+    std::vector<double> speeds;
+    std::vector<int> pieceCounts;
+    for (const GameResult &result : results)
+    {
+        pieces += result.pieces;
+        searchNodes += result.searchNodes;
+        searchSeconds += result.searchSeconds;
+        scores.push_back(result.score);
+        speeds.push_back(result.speed);
+        pieceCounts.push_back(result.pieces);
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Time: " << seconds << " s\tGames/s: " << games / seconds << "\tPieces/s: " << pieces / seconds << std::endl;
+    if (lookahead > 1)
+        std::cout << "Search nodes: " << searchNodes << "\tNodes/s: " << searchNodes / seconds
+                  << " (" << searchNodes / searchSeconds << " per searching thread)" << std::endl;
+    printDistribution("score", scores);
+    printDistribution("speed", speeds);
+    printDistribution("pieces", pieceCounts);
+
+    return 0;
+}
@@ -3,11 +3,26 @@
 
 #include <glad/glad.h>
 
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Binding points of the uniform blocks shared by all programs, every Shader connects the ones it uses when it's linked
+#define MATERIAL_TABLE_BINDING 0 // MaterialTable, see initMaterials
+#define FRAME_BINDING 1          // Frame, see FrameUniforms
+#define LIGHTS_BINDING 2         // Lights, see FrameUniforms
+
+template <typename T> class UniformHandle;
 
+// Uniform locations are looked up once after linking, and a value is only uploaded when it differs from the last one
+// set through this class. Like glUniform*, the setters need the program to be in use
 class Shader
 {
 	public:
@@ -85,6 +100,14 @@ class Shader
 
 			glDeleteShader(vertex);
 			glDeleteShader(fragment);
+
+			if (success)
+			{
+				loadUniforms();
+				bindUniformBlock("MaterialTable", MATERIAL_TABLE_BINDING);
+				bindUniformBlock("Frame", FRAME_BINDING);
+				bindUniformBlock("Lights", LIGHTS_BINDING);
+			}
 		}
 
 		void use()
@@ -96,30 +119,142 @@ class Shader
 			glDeleteProgram(ID);
 		}
 
-		void setBool(const std::string &name, bool value) const
+		// Connect the uniform block name (if the program uses it) to a binding point of glBindBufferBase
+		void bindUniformBlock(const std::string &name, unsigned int binding) const
+		{
+			unsigned int index = glGetUniformBlockIndex(ID, name.c_str());
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(ID, index, binding);
+		}
+
+		// Resolve name once, for uniforms set in the render loop (an unknown name gives a handle that does nothing)
+		template <typename T>
+		UniformHandle<T> getUniform(const std::string &name);
+
+		void setBool(const std::string &name, bool value)
+		{
+			set(findSlot(name), (int)value);
+		}
+		void setInt(const std::string &name, int value)
+		{
+			set(findSlot(name), value);
+		}
+		void setFloat(const std::string &name, float value)
+		{
+			set(findSlot(name), value);
+		}
+		void setVec3(const std::string &name, const glm::vec3 &value)
+		{
+			set(findSlot(name), value);
+		}
+		void setVec3(const std::string &name, float x, float y, float z)
+		{
+			set(findSlot(name), glm::vec3(x, y, z));
+		}
+		void setMat4(const std::string &name, const glm::mat4 &value)
 		{
-			glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+			set(findSlot(name), value);
 		}
-		void setInt(const std::string &name, int value) const
+
+	private:
+		template <typename T> friend class UniformHandle;
+
+		struct UniformSlot
 		{
-			glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+			int location;
+			bool uploaded = false; // value holds what the program has
+			unsigned char value[sizeof(glm::mat4)];
+		};
+		std::vector<UniformSlot> slots;
+		std::unordered_map<std::string, int> slotIndices; // uniform name -> index into slots
+
+		// Every active uniform outside of uniform blocks gets a slot, each element of arrays of basic types too
+		void loadUniforms()
+		{
+			int count;
+			glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+			for (int i = 0; i < count; i++)
+			{
+				char name[256];
+				int length, size;
+				unsigned int type;
+				glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+
+				std::string uniformName(name, length);
+				if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+				{
+					std::string arrayName = uniformName.substr(0, uniformName.size() - 3);
+					for (int e = 0; e < size; e++)
+						addSlot(arrayName + "[" + std::to_string(e) + "]");
+					if (slotIndices.count(uniformName))
+						slotIndices[arrayName] = slotIndices[uniformName]; // the array name refers to element 0
+				}
+				else
+					addSlot(uniformName);
+			}
 		}
-		void setFloat(const std::string &name, float value) const
+		void addSlot(const std::string &name)
 		{
-			glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+			int location = glGetUniformLocation(ID, name.c_str());
+			if (location < 0)
+				return; // member of a uniform block
+
+			slotIndices[name] = slots.size();
+			slots.push_back({ location });
 		}
-		void setVec3(const std::string &name, glm::vec3 &value) const
+		int findSlot(const std::string &name) const
 		{
-			glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+			auto it = slotIndices.find(name);
+			return it != slotIndices.end() ? it->second : -1;
 		}
-		void setVec3(const std::string &name, float x, float y, float z) const
+
+		template <typename T>
+		void set(int slot, const T &value)
 		{
-			glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+			static_assert(sizeof(T) <= sizeof(glm::mat4), "Uniform type too large for the cache");
+			if (slot < 0)
+				return;
+
+			UniformSlot &uniform = slots[slot];
+			if (uniform.uploaded && std::memcmp(uniform.value, &value, sizeof(T)) == 0)
+				return;
+
+			std::memcpy(uniform.value, &value, sizeof(T));
+			uniform.uploaded = true;
+			upload(uniform.location, value);
 		}
-		void setMat4(const std::string &name, glm::mat4 &value) const
+
+		static void upload(int location, int value) { glUniform1i(location, value); }
+		static void upload(int location, float value) { glUniform1f(location, value); }
+		static void upload(int location, const glm::vec3 &value) { glUniform3fv(location, 1, glm::value_ptr(value)); }
+		static void upload(int location, const glm::mat4 &value) { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+};
+
+// Uniform of a Shader resolved ahead of time: set() does no name lookup and skips values the program already has.
+// T is int (also for bools and samplers), float, glm::vec3 or glm::mat4. The Shader has to outlive the handle
+template <typename T>
+class UniformHandle
+{
+	public:
+		UniformHandle() {}
+		UniformHandle(Shader *shader, int slot) : shader(shader), slot(slot) {}
+
+		void set(const T &value) const
 		{
-			glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+			if (shader)
+				shader->set(slot, value);
 		}
+		bool isValid() const { return shader && slot >= 0; }
+
+	private:
+		Shader *shader = nullptr;
+		int slot = -1;
 };
 
+template <typename T>
+UniformHandle<T> Shader::getUniform(const std::string &name)
+{
+	return UniformHandle<T>(this, findSlot(name));
+}
+
 #endif
\ No newline at end of file
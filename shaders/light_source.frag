@@ -1,14 +1,15 @@
 #version 330 core
 
+// Layer MaterialIndex holds the textures of a material
 struct Material {
-	sampler2D diffuse;
-	sampler2D specular;
-	float shininess;
+	sampler2DArray diffuse;
+	sampler2DArray specular;
 };
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in int MaterialIndex;
 
 uniform Material material;
 
@@ -16,5 +17,5 @@ out vec4 FragColor;
 
 void main()
 {
-	FragColor = vec4(vec3(texture(material.diffuse, TexCoords)), 1.0);
+	FragColor = vec4(vec3(texture(material.diffuse, vec3(TexCoords, MaterialIndex))), 1.0);
 }
\ No newline at end of file
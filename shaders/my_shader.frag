@@ -1,9 +1,9 @@
 #version 330 core
 
+// Layer MaterialIndex holds the textures of a material
 struct Material {
-	sampler2D diffuse;
-	sampler2D specular;
-	float shininess;
+	sampler2DArray diffuse;
+	sampler2DArray specular;
 };
 
 struct DirectionalLight {
@@ -13,29 +13,38 @@ struct DirectionalLight {
 	vec3 diffuse;
 	vec3 specular;
 };
-struct PointLight {
+struct PointLight { // the attenuation terms fill the std140 padding after the vec3s
 	vec3 position;
-
-	vec3 ambient;
-	vec3 diffuse;
-	vec3 specular;
-
 	float constant;
+	vec3 ambient;
 	float linear;
+	vec3 diffuse;
 	float quadratic;
+	vec3 specular;
 };
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in int MaterialIndex;
 
 uniform bool discoMode;
 uniform float alpha; // transparency factor
-uniform vec3 viewPos;
+layout (std140) uniform Frame { // shared by all programs, see FrameUniforms
+	mat4 view;
+	mat4 projection;
+	vec3 viewPos;
+};
 uniform Material material;
-uniform DirectionalLight dirLight;
+#define MAX_MATERIALS 16
+layout (std140) uniform MaterialTable {
+	float shininess[MAX_MATERIALS]; // per material
+};
 #define NR_POINT_LIGHTS 4
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+layout (std140) uniform Lights { // shared by all programs, see FrameUniforms
+	DirectionalLight dirLight;
+	PointLight pointLights[NR_POINT_LIGHTS];
+};
 
 out vec4 FragColor;
 
@@ -57,30 +66,30 @@ void main()
 
 vec3 calcDirLight(DirectionalLight light, vec3 normal, vec3 viewDir)
 {
-	vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+	vec3 ambient = light.ambient * vec3(texture(material.diffuse, vec3(TexCoords, MaterialIndex)));
 
 	vec3 lightDir = normalize(light.direction);
 	float diff = max(dot(normal, lightDir), 0.0);
-	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+	vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vec3(TexCoords, MaterialIndex)));
 
 	vec3 reflectDir = reflect(-lightDir, normal);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-	vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess[MaterialIndex]);
+	vec3 specular = light.specular * spec * vec3(texture(material.specular, vec3(TexCoords, MaterialIndex)));
 
 	return ambient + diffuse + specular;
 }
 
 vec3 calcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
+    vec3 ambient = light.ambient * vec3(texture(material.diffuse, vec3(TexCoords, MaterialIndex)));
 
 	vec3 lightDir = normalize(light.position - fragPos);
     float diff = max(dot(normal, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, vec3(TexCoords, MaterialIndex)));
 	
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess[MaterialIndex]);
+    vec3 specular = light.specular * spec * vec3(texture(material.specular, vec3(TexCoords, MaterialIndex)));
 
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
@@ -3,20 +3,27 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 4) in int aMaterialIndex; // per vertex in the static block mesh, set for the whole draw with glVertexAttribI1i otherwise
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+flat out int MaterialIndex;
 
+layout (std140) uniform Frame { // shared by all programs, see FrameUniforms
+    mat4 view;
+    mat4 projection;
+    vec3 viewPos;
+};
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform bool discoMode;
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;
     TexCoords = aTexCoords;
+    MaterialIndex = discoMode ? 0 : aMaterialIndex; // everything is white in disco mode
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -1,7 +1,19 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <algorithm>
+
 #include "constants.hpp"
 
 #define SHAPE_WIDTH 3
+#define MAX_SHAPE_CELLS 4
+#define MAX_ORIENTATIONS 24
+
 
+struct ShapeCell
+{
+    int x, y, z;
+};
 
 class Shape
 {
@@ -9,19 +21,30 @@ class Shape
         int count;
         bool positions[SHAPE_WIDTH][SHAPE_WIDTH][SHAPE_WIDTH];
 
-        void rotate(Axis, Transformation);
-        Shape getRotated(Axis, Transformation);
+        // Derived from positions by update(), so loops over a Shape only visit its occupied cells
+        ShapeCell cells[MAX_SHAPE_CELLS] = {};
+        ShapeCell boundsMin = {}; // bounding box of occupied cells (inclusive)
+        ShapeCell boundsMax = {};
+        unsigned int layerBits[SHAPE_WIDTH] = {}; // per y-layer, bit (i * SHAPE_WIDTH + k) is set for cell [i][j][k]
+        int columnBottoms[SHAPE_WIDTH * SHAPE_WIDTH] = {}; // lowest y in column (i * SHAPE_WIDTH + k), -1 if the column is empty
 
-        int getLowestIndex();
+        constexpr void update();
+        constexpr void rotate(Axis, Transformation);
+        constexpr Shape getRotated(Axis, Transformation) const;
+        constexpr bool isSameAs(const Shape &) const;
+        constexpr bool isTranslationOf(const Shape &) const;
+
+        int getLowestIndex() const { return boundsMin.y; }
+        unsigned int getLayerBits(int j) const { return layerBits[j]; }
 
     private:
-        bool getPositionAt(Axis a, unsigned int p, unsigned int q, unsigned int r)
+        constexpr bool getPositionAt(Axis a, unsigned int p, unsigned int q, unsigned int r) const
         {
             if (a == AXIS_X) return positions[r][p][q];
             else if (a == AXIS_Y) return positions[p][r][q];
             else return positions[p][q][r];
         }
-        void setPositionAt(Axis a, unsigned int p, unsigned int q, unsigned int r, bool val)
+        constexpr void setPositionAt(Axis a, unsigned int p, unsigned int q, unsigned int r, bool val)
         {
             if (a == AXIS_X) positions[r][p][q] = val;
             else if (a == AXIS_Y) positions[p][r][q] = val;
@@ -29,7 +52,32 @@ class Shape
         }
 };
 
-void Shape::rotate(Axis axis, Transformation rd)
+constexpr void Shape::update()
+{
+    count = 0;
+    boundsMin = { SHAPE_WIDTH, SHAPE_WIDTH, SHAPE_WIDTH };
+    boundsMax = { -1, -1, -1 };
+    for (int j = 0; j < SHAPE_WIDTH; j++)
+        layerBits[j] = 0;
+    for (int c = 0; c < SHAPE_WIDTH * SHAPE_WIDTH; c++)
+        columnBottoms[c] = -1;
+
+    for (int i = 0; i < SHAPE_WIDTH; i++)
+        for (int j = 0; j < SHAPE_WIDTH; j++)
+            for (int k = 0; k < SHAPE_WIDTH; k++)
+                if (positions[i][j][k])
+                {
+                    cells[count++] = { i, j, k };
+
+                    boundsMin = { std::min(boundsMin.x, i), std::min(boundsMin.y, j), std::min(boundsMin.z, k) };
+                    boundsMax = { std::max(boundsMax.x, i), std::max(boundsMax.y, j), std::max(boundsMax.z, k) };
+                    layerBits[j] |= 1u << (i * SHAPE_WIDTH + k);
+                    if (columnBottoms[i * SHAPE_WIDTH + k] < 0)
+                        columnBottoms[i * SHAPE_WIDTH + k] = j;
+                }
+}
+
+constexpr void Shape::rotate(Axis axis, Transformation rd)
 {
     if (rd != ROT_CCW && rd != ROT_CW)
         return;
@@ -67,65 +115,47 @@ void Shape::rotate(Axis axis, Transformation rd)
             for (int q = 0; q < SHAPE_WIDTH; q++)
                 setPositionAt(axis, p, q, r, arr[p][q]);
     }
+
+    update();
 }
 
-Shape Shape::getRotated(Axis axis, Transformation rd)
+constexpr Shape Shape::getRotated(Axis axis, Transformation rd) const
 {
-    // REVIEW: pretpostavlja se validni rd
-
-    Shape rotated;
-    rotated.count = this->count;
-
-    for (int r = 0; r < SHAPE_WIDTH; r++) // r - axis on which rotation is being performed
-    {
-        bool arr[SHAPE_WIDTH][SHAPE_WIDTH] = { 0 }; // current XZ matrix
-        for (int p = 0; p < SHAPE_WIDTH; p++)
-            for (int q = 0; q < SHAPE_WIDTH; q++)
-                arr[p][q] = getPositionAt(axis, p, q, r);
-
-        // Transpose matrix
-        bool tarr[SHAPE_WIDTH][SHAPE_WIDTH] = { 0 };
-        for (int p = 0; p < SHAPE_WIDTH; p++)
-            for (int q = 0; q < SHAPE_WIDTH; q++)
-                tarr[p][q] = arr[q][p];
-        
-        if (rd == ROT_CCW)
-        {
-            // Reverse each *row* of transposed matrix
-            for (int p = 0; p < SHAPE_WIDTH; p++)
-                for (int q = 0; q < SHAPE_WIDTH; q++)
-                    arr[p][q] = tarr[p][SHAPE_WIDTH - q - 1];
-        }
-        else if (rd == ROT_CW)
-        {
-            // Reverse each *column* of transposed matrix
-            for (int p = 0; p < SHAPE_WIDTH; p++)
-                for (int q = 0; q < SHAPE_WIDTH; q++)
-                    arr[p][q] = tarr[SHAPE_WIDTH - p - 1][q];
-        }
-
-        // Update positions
-        for (int p = 0; p < SHAPE_WIDTH; p++)
-            for (int q = 0; q < SHAPE_WIDTH; q++)
-                rotated.setPositionAt(axis, p, q, r, arr[p][q]);
-    }
+    Shape rotated = *this;
+    rotated.rotate(axis, rd);
 
     return rotated;
 }
 
-// Get y-index of lowest block in Shape
-int Shape::getLowestIndex()
+constexpr bool Shape::isSameAs(const Shape &other) const
 {
-    for (int j = 0; j < SHAPE_WIDTH; j++)
-        for (int i = 0; i < SHAPE_WIDTH; i++)
+    for (int i = 0; i < SHAPE_WIDTH; i++)
+        for (int j = 0; j < SHAPE_WIDTH; j++)
             for (int k = 0; k < SHAPE_WIDTH; k++)
-                if (positions[i][j][k])
-                    return j;
+                if (positions[i][j][k] != other.positions[i][j][k])
+                    return false;
+
+    return true;
+}
+
+// Same cells, possibly at a different position within the 3x3x3 grid
+constexpr bool Shape::isTranslationOf(const Shape &other) const
+{
+    if (count != other.count)
+        return false;
 
-    return SHAPE_WIDTH - 1; // REVIEW: ovo je postavljeno jer inače bude warning da nema return; svakako bi loop uvik treba nać indeks
+    // cells are sorted by (x, y, z), which is kept when both are moved to the origin
+    for (int c = 0; c < count; c++)
+        if (cells[c].x - boundsMin.x != other.cells[c].x - other.boundsMin.x ||
+                cells[c].y - boundsMin.y != other.cells[c].y - other.boundsMin.y ||
+                cells[c].z - boundsMin.z != other.cells[c].z - other.boundsMin.z)
+            return false;
+
+    return true;
 }
 
-Shape shapes[] = {
+// Initial orientation of every Shape; only positions and count are given, use shapeOrientations for the derived data
+constexpr Shape shapes[] = {
     {
         // straight / I
         .count = 3,
@@ -302,4 +332,77 @@ Shape shapes[] = {
             }
         }
     },
-};
\ No newline at end of file
+};
+
+#define SHAPE_COUNT (int) (sizeof(shapes) / sizeof(Shape))
+
+
+// ORIENTATIONS
+
+inline int getRotationIndex(Transformation rd) { return rd == ROT_CW ? 0 : 1; }
+
+// All distinct orientations of a Shape, reachable from its initial orientation (index 0) by rotations
+struct ShapeOrientations
+{
+    int count; // number of distinct orientations
+    Shape orientations[MAX_ORIENTATIONS];
+    int next[MAX_ORIENTATIONS][3][2]; // [orientation][Axis][getRotationIndex(rd)] -> rotated orientation
+
+    // Orientations that aren't a translation of an earlier one, i.e. the ones that give distinct placements
+    int uniqueCount;
+    int unique[MAX_ORIENTATIONS];
+    int canonical[MAX_ORIENTATIONS]; // first orientation (one of unique) that each orientation is a translation of
+};
+
+constexpr ShapeOrientations buildOrientations(const Shape &shape)
+{
+    const Transformation directions[] = { ROT_CW, ROT_CCW };
+
+    ShapeOrientations result = {};
+    result.orientations[0] = shape;
+    result.orientations[0].update();
+    result.count = 1;
+
+    // Every orientation is visited once; rotating it around each axis either finds an already known orientation or appends a new one
+    for (int o = 0; o < result.count; o++)
+        for (int a = AXIS_X; a <= AXIS_Z; a++)
+            for (int d = 0; d < 2; d++)
+            {
+                Shape rotated = result.orientations[o].getRotated((Axis) a, directions[d]);
+
+                int n = 0;
+                while (n < result.count && !result.orientations[n].isSameAs(rotated))
+                    n++;
+                if (n == result.count)
+                    result.orientations[result.count++] = rotated;
+
+                result.next[o][a][d] = n;
+            }
+
+    result.uniqueCount = 0;
+    for (int o = 0; o < result.count; o++)
+    {
+        int n = 0;
+        while (n < o && !result.orientations[n].isTranslationOf(result.orientations[o]))
+            n++;
+        if (n == o)
+            result.unique[result.uniqueCount++] = o;
+        result.canonical[o] = n;
+    }
+
+    return result;
+}
+
+constexpr ShapeOrientations shapeOrientations[] = {
+    buildOrientations(shapes[0]),
+    buildOrientations(shapes[1]),
+    buildOrientations(shapes[2]),
+    buildOrientations(shapes[3]),
+    buildOrientations(shapes[4]),
+    buildOrientations(shapes[5]),
+    buildOrientations(shapes[6]),
+    buildOrientations(shapes[7]),
+};
+static_assert(sizeof(shapeOrientations) / sizeof(ShapeOrientations) == SHAPE_COUNT, "Every Shape needs an orientation table");
+
+#endif
@@ -0,0 +1,114 @@
+// Consistency check of GameCore snapshots: headless Bot games in which the game is snapshotted and restored right
+// after every lock (before the next piece spawned). After every step, the Area's per-layer counts and hash have to
+// match its blocks, and every locked piece has to add its cells exactly once
+//
+// usage: snapshotcheck [games] [max pieces per game]
+
+#include "game_core.hpp"
+#include "bot.hpp"
+
+#include <bit>
+#include <iostream>
+#include <string>
+
+
+// Returns an empty string if the row counts and the hash of area match its occupancy
+std::string checkArea(const Area &area)
+{
+    Area rebuilt;
+    for (int y = 0; y < Area::HEIGHT; y++)
+    {
+        int count = 0;
+        for (int w = 0; w < LayerMask<Area::WIDTH>::WORDS; w++)
+            count += std::popcount(area.getLayer(y).occupancy.words[w]);
+        if (count != area.getRowCount(y))
+            return "layer " + std::to_string(y) + " counts " + std::to_string(area.getRowCount(y)) + " cells, but has " + std::to_string(count);
+
+        for (int x = 0; x < Area::WIDTH; x++)
+            for (int z = 0; z < Area::WIDTH; z++)
+                if (area.isOccupied(x, y, z))
+                    rebuilt.addBlock(x, y, z, area.getMaterial(x, y, z));
+    }
+
+    if (rebuilt.getHash() != area.getHash())
+        return "hash doesn't match the blocks";
+    return "";
+}
+
+int getCellCount(const Area &area)
+{
+    int cells = 0;
+    for (int y = 0; y < Area::HEIGHT; y++)
+        cells += area.getRowCount(y);
+    return cells;
+}
+
+// Plays one game, returns false (and prints why) on the first inconsistency
+bool checkGame(uint64_t seed, int maxPieces, int &totalLocks, int &totalRowsCleared)
+{
+    GameCore game;
+    game.logging = false;
+    game.pieces.reset(seed);
+
+    Bot bot(game);
+    bot.actionsPerUpdate = 1000;
+
+    int locks = 0, cellsLocked = 0, rowsCleared = 0;
+    game.subscribe([&](const GameEvent &event) {
+        if (event.type == PIECE_LOCKED)
+        {
+            locks++;
+            cellsLocked += game.player.shape.count;
+        }
+        else if (event.type == ROWS_CLEARED)
+            rowsCleared += event.value;
+    });
+
+    int restored = 0;
+    for (int frame = 0; game.state == ACTIVE && locks < maxPieces; frame++)
+    {
+        bot.update();
+        game.step(1.0 / 60.0);
+
+        if (locks > restored)
+        {
+            // Restore the game exactly as it is: nothing may change
+            GameState snapshot = game.getSnapshot();
+            game.restoreSnapshot(snapshot);
+            restored = locks;
+        }
+
+        std::string error = checkArea(game.area);
+        if (error.empty() && getCellCount(game.area) != cellsLocked - rowsCleared * Area::WIDTH * Area::WIDTH)
+            error = std::to_string(getCellCount(game.area)) + " cells in the Area after locking " + std::to_string(cellsLocked)
+                  + " and clearing " + std::to_string(rowsCleared) + " layers";
+        if (!error.empty())
+        {
+            std::cout << "Seed " << seed << ", piece " << locks << ", frame " << frame << ": " << error << std::endl;
+            return false;
+        }
+    }
+
+    totalLocks += locks;
+    totalRowsCleared += rowsCleared;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    int games = argc > 1 ? std::stoi(argv[1]) : 8;
+    int maxPieces = argc > 2 ? std::stoi(argv[2]) : 200;
+    if (games < 1 || maxPieces < 1)
+    {
+        std::cout << "usage: snapshotcheck [games] [max pieces per game]" << std::endl;
+        return 1;
+    }
+
+    int locks = 0, rowsCleared = 0;
+    for (int g = 0; g < games; g++)
+        if (!checkGame(g + 1, maxPieces, locks, rowsCleared))
+            return 1;
+
+    std::cout << "Restored " << locks << " snapshots in " << games << " games (" << rowsCleared << " layers cleared), all consistent" << std::endl;
+    return 0;
+}
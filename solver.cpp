@@ -0,0 +1,444 @@
+// Offline puzzle solver: given a starting Area and a fixed sequence of Shapes, searches for placements that leave the
+// Area empty after the last piece ("clear"), or that clear the most layers ("max"). Depth-first search with bound
+// pruning and a shared table of visited states; the top of the tree is split into many small tasks which idle threads pick up.
+// Pieces spawn where GameCore puts them, but always in orientation 0 instead of PieceSource's random one, so a puzzle
+// doesn't depend on a seed; only placements PathPlanner can reach from there are tried
+//
+// usage: solver <puzzle file> [clear|max] [threads] [node limit, 0 = none]
+//
+// Puzzle file: "shapes" followed by shape indices, then the layers from the bottom up, each one starting with a "layer"
+// line and followed by AREA_WIDTH lines (z) of AREA_WIDTH characters (x): '.' is empty, '#' or a digit is a block (material).
+// Lines starting with '//' are ignored
+
+#include "game_core.hpp"
+#include "placement.hpp"
+#include "evaluation.hpp"
+#include "thread_pool.hpp"
+#include "transposition_table.hpp"
+#include "zobrist.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#define LAYER_CELLS (Area::WIDTH * Area::WIDTH)
+
+enum Goal {
+    GOAL_CLEAR, // Area empty after the last piece
+    GOAL_MAX    // most layers cleared
+};
+
+struct Puzzle
+{
+    Area area;
+    std::vector<int> shapes;
+};
+
+bool loadPuzzle(const std::string &path, Puzzle &puzzle)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cout << "Can't open " << path << std::endl;
+        return false;
+    }
+
+    int y = -1, z = 0;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line.rfind("//", 0) == 0)
+            continue;
+
+        std::istringstream words(line);
+        std::string word;
+        words >> word;
+        if (word == "shapes")
+        {
+            int shapeIndex;
+            while (words >> shapeIndex)
+            {
+                if (shapeIndex < 0 || shapeIndex >= SHAPE_COUNT)
+                {
+                    std::cout << "Unknown shape " << shapeIndex << std::endl;
+                    return false;
+                }
+                puzzle.shapes.push_back(shapeIndex);
+            }
+        }
+        else if (word == "layer")
+        {
+            if (++y >= Area::HEIGHT)
+            {
+                std::cout << "More than " << Area::HEIGHT << " layers" << std::endl;
+                return false;
+            }
+            z = 0;
+        }
+        else
+        {
+            if (y < 0 || z >= Area::WIDTH || (int) line.size() < Area::WIDTH)
+            {
+                std::cout << "Unexpected line: " << line << std::endl;
+                return false;
+            }
+            for (int x = 0; x < Area::WIDTH; x++)
+                if (line[x] == '#')
+                    puzzle.area.addBlock(x, y, z, 1);
+                else if (line[x] >= '0' && line[x] <= '9')
+                    puzzle.area.addBlock(x, y, z, line[x] - '0');
+            z++;
+        }
+    }
+
+    puzzle.area.clearFullLayers(); // also leaves the heights consistent with blocks under overhangs
+    return !puzzle.shapes.empty();
+}
+
+int getCellCount(const Area &area)
+{
+    int cells = 0;
+    for (int y = 0; y < Area::HEIGHT; y++)
+        cells += area.getRowCount(y);
+    return cells;
+}
+
+// Every non-empty layer has to be cleared to empty the Area, and each remaining cell fills at most one gap
+bool canStillClear(const Area &area, int remainingCells)
+{
+    int gaps = 0;
+    for (int y = 0; y < Area::HEIGHT; y++)
+        if (area.getRowCount(y) > 0)
+            gaps += LAYER_CELLS - area.getRowCount(y);
+
+    return gaps <= remainingCells;
+}
+
+// Subtree still to be searched: a state after the first pieces, and how it was reached
+struct Task
+{
+    Area area;
+    int cleared;
+    double value; // evaluateArea(), promising tasks are searched first
+    std::vector<Placement> path;
+};
+
+class Solver
+{
+    public:
+        Goal goal = GOAL_CLEAR;
+        long long nodeLimit = 0; // 0 = unlimited
+
+        // Results
+        bool solved = false;
+        int bestCleared = -1;
+        std::vector<Placement> bestPath;
+        std::atomic<long long> nodes{0};
+
+        Solver(const Puzzle &puzzle, ThreadPool &pool);
+
+        void solve();
+
+    private:
+        struct Child
+        {
+            Placement placement;
+            double value;
+        };
+
+        // Scratch memory of one pool thread
+        struct Worker
+        {
+            PathPlanner<Area::WIDTH, Area::HEIGHT> planner;
+            std::vector<Placement> placements;
+            std::vector<std::vector<Child>> children; // per depth
+            std::vector<Area> areas;                  // per depth
+            std::vector<Placement> path;
+            long long nodes = 0; // not yet added to Solver::nodes
+        };
+
+        const Puzzle &puzzle;
+        ThreadPool &pool;
+        TranspositionTable table; // states already searched (or being searched), keyed by Area hash and piece index
+        std::vector<int> remainingCells; // cells of pieces [i, end)
+        std::vector<Worker> workers;
+
+        std::mutex resultMutex;
+        std::atomic<int> best{-1};
+        std::atomic<bool> stop{false};
+
+        Player getPiece(int index, const Area &) const;
+        void getChildren(const Area &, int index, Worker &, std::vector<Child> &children);
+        void record(int cleared, const std::vector<Placement> &path, int length);
+        bool isPromising(const Area &, int index, int cleared) const;
+        bool enter(const Area &, int index, int cleared, const std::vector<Placement> &path);
+        void search(int index, int cleared, Worker &);
+        void searchChildren(int index, int cleared, Worker &);
+};
+
+Solver::Solver(const Puzzle &puzzle, ThreadPool &pool) : puzzle(puzzle), pool(pool), table(22), workers(pool.getThreadCount())
+{
+    int count = (int) puzzle.shapes.size();
+    remainingCells.assign(count + 1, 0);
+    for (int i = count - 1; i >= 0; i--)
+        remainingCells[i] = remainingCells[i + 1] + shapeOrientations[puzzle.shapes[i]].orientations[0].count;
+
+    for (Worker &worker : workers)
+    {
+        worker.children.resize(count);
+        worker.areas.resize(count + 1);
+        worker.path.resize(count);
+    }
+}
+
+// Piece index at the position GameState::spawn() would give it, in orientation 0 (see the top of the file)
+Player Solver::getPiece(int index, const Area &area) const
+{
+    Player piece;
+    piece.setShape(puzzle.shapes[index]);
+    piece.setOrientation(0);
+    piece.offset = glm::ivec3((area.WIDTH - SHAPE_WIDTH) / 2, area.HEIGHT - piece.shape.getLowestIndex(), (area.WIDTH - SHAPE_WIDTH) / 2);
+    return piece;
+}
+
+// Placements of piece index which don't end the game, best evaluated first so good results are found early
+void Solver::getChildren(const Area &area, int index, Worker &worker, std::vector<Child> &children)
+{
+    Player piece = getPiece(index, area);
+    worker.planner.getReachablePlacements(area, piece, worker.placements);
+
+    const ShapeOrientations &orientations = shapeOrientations[piece.shapeIndex];
+    BotWeights weights;
+    children.clear();
+    for (const Placement &placement : worker.placements)
+    {
+        const Shape &shape = orientations.orientations[placement.orientation];
+        if (!area.isAboveTop(shape, placement.offset))
+            children.push_back({ placement, evaluatePlacement(area, shape, placement.offset, weights) });
+    }
+
+    std::sort(children.begin(), children.end(), [](const Child &a, const Child &b) { return a.value > b.value; });
+}
+
+void Solver::record(int cleared, const std::vector<Placement> &path, int length)
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (cleared <= bestCleared)
+        return;
+
+    bestCleared = cleared;
+    best = cleared;
+    bestPath.assign(path.begin(), path.begin() + length);
+}
+
+// Whether the subtree below the state after placing pieces [0, index) can still reach the goal, or beat the best result so far
+bool Solver::isPromising(const Area &area, int index, int cleared) const
+{
+    if (goal == GOAL_CLEAR)
+        return canStillClear(area, remainingCells[index]);
+
+    return cleared + (getCellCount(area) + remainingCells[index]) / LAYER_CELLS > best.load(std::memory_order_relaxed);
+}
+
+// Visit the state after placing pieces [0, index) with path: record it if it is a result, and mark it as searched;
+// returns false if its children don't need to be searched (pruned, already searched, or no pieces left)
+bool Solver::enter(const Area &area, int index, int cleared, const std::vector<Placement> &path)
+{
+    int count = (int) puzzle.shapes.size();
+    if (goal == GOAL_MAX && cleared > best.load(std::memory_order_relaxed))
+        record(cleared, path, index);
+    if (index == count)
+    {
+        if (goal == GOAL_CLEAR && getCellCount(area) == 0)
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (!solved)
+            {
+                solved = true;
+                bestCleared = cleared;
+                bestPath.assign(path.begin(), path.begin() + index);
+            }
+            stop = true;
+        }
+        return false;
+    }
+
+    if (!isPromising(area, index, cleared))
+        return false;
+
+    // The cleared layers follow from the Area and the pieces placed, so a state is only ever worth searching once
+    uint64_t key = area.getHash() ^ mixHash(index + 1);
+    TranspositionTable::Entry entry;
+    if (table.probe(key, entry))
+        return false;
+    table.store(key, { (float) cleared, count - index });
+
+    return true;
+}
+
+// Search below worker.areas[index], the state after placing pieces [0, index)
+void Solver::search(int index, int cleared, Worker &worker)
+{
+    if (stop.load(std::memory_order_relaxed))
+        return;
+
+    if (++worker.nodes == 4096)
+    {
+        long long total = nodes.fetch_add(worker.nodes) + worker.nodes;
+        worker.nodes = 0;
+        if (nodeLimit > 0 && total >= nodeLimit)
+            stop = true;
+    }
+
+    if (enter(worker.areas[index], index, cleared, worker.path))
+        searchChildren(index, cleared, worker);
+}
+
+// Search the children of worker.areas[index], which was already entered
+void Solver::searchChildren(int index, int cleared, Worker &worker)
+{
+    const Area &area = worker.areas[index];
+    std::vector<Child> &children = worker.children[index];
+    getChildren(area, index, worker, children);
+
+    const Shape *orientations = shapeOrientations[puzzle.shapes[index]].orientations;
+    for (const Child &child : children)
+    {
+        Area &next = worker.areas[index + 1];
+        next = area;
+        next.addShape(orientations[child.placement.orientation], child.placement.offset, puzzle.shapes[index] + 1);
+        int rowsCleared = next.clearFullLayers();
+
+        worker.path[index] = child.placement;
+        search(index + 1, cleared + rowsCleared, worker);
+        if (stop.load(std::memory_order_relaxed))
+            return;
+    }
+}
+
+void Solver::solve()
+{
+    int count = (int) puzzle.shapes.size();
+    if (goal == GOAL_CLEAR && (getCellCount(puzzle.area) + remainingCells[0]) % LAYER_CELLS != 0)
+        return; // the cells can't add up to whole layers
+
+    std::vector<Task> tasks(1);
+    tasks[0] = { puzzle.area, 0, 0.0, {} };
+    if (!enter(puzzle.area, 0, 0, tasks[0].path))
+        return;
+
+    // Expand the first pieces breadth-first until there are plenty of tasks per thread, so no thread runs out of work
+    // while another one is stuck in a large subtree. Every child is entered like in search(), so the pruning and the
+    // table apply here too (the same Area reached in different orders becomes one task), and tasks only search children
+    Worker &worker = workers[0];
+    BotWeights weights;
+    int index = 0;
+    for (; index < count && !tasks.empty() && (int) tasks.size() < pool.getThreadCount() * 32 && !stop; index++)
+    {
+        std::vector<Task> next;
+        for (const Task &task : tasks)
+        {
+            if (!isPromising(task.area, index, task.cleared))
+                continue; // the best result improved since the task was entered
+
+            getChildren(task.area, index, worker, worker.children[index]);
+            for (const Child &child : worker.children[index])
+            {
+                Task expanded = { task.area, task.cleared, 0.0, task.path };
+                expanded.area.addShape(shapeOrientations[puzzle.shapes[index]].orientations[child.placement.orientation], child.placement.offset, puzzle.shapes[index] + 1);
+                expanded.cleared += expanded.area.clearFullLayers();
+                expanded.path.push_back(child.placement);
+                nodes++;
+                if (!enter(expanded.area, index + 1, expanded.cleared, expanded.path))
+                    continue;
+
+                expanded.value = evaluateArea(expanded.area, weights) + weights.layerCompleteness * expanded.cleared;
+                next.push_back(std::move(expanded));
+            }
+        }
+
+        // Promising tasks first, here and in the threads below
+        std::sort(next.begin(), next.end(), [](const Task &a, const Task &b) { return a.value > b.value; });
+        tasks = std::move(next);
+    }
+
+    // Threads take the next task as soon as they finish one; they share the table and the best result, so they prune for each other
+    pool.parallelFor((int) tasks.size(), [&](int i, int thread) {
+        if (stop.load(std::memory_order_relaxed))
+            return;
+
+        const Task &task = tasks[i];
+        if (!isPromising(task.area, index, task.cleared))
+            return; // the best result improved since the task was entered
+
+        Worker &worker = workers[thread];
+        std::copy(task.path.begin(), task.path.end(), worker.path.begin());
+        worker.areas[index] = task.area;
+        searchChildren(index, task.cleared, worker);
+    });
+
+    for (Worker &worker : workers)
+    {
+        nodes += worker.nodes;
+        worker.nodes = 0;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: solver <puzzle file> [clear|max] [threads] [node limit, 0 = none]" << std::endl;
+        return 1;
+    }
+    std::string goalName = argc > 2 ? argv[2] : "clear";
+    int threads = argc > 3 ? std::stoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+    long long nodeLimit = argc > 4 ? std::stoll(argv[4]) : 0;
+    if ((goalName != "clear" && goalName != "max") || threads < 1 || nodeLimit < 0)
+    {
+        std::cout << "usage: solver <puzzle file> [clear|max] [threads] [node limit, 0 = none]" << std::endl;
+        return 1;
+    }
+
+    Puzzle puzzle;
+    if (!loadPuzzle(argv[1], puzzle))
+        return 1;
+
+    ThreadPool pool(threads);
+    Solver solver(puzzle, pool);
+    solver.goal = goalName == "clear" ? GOAL_CLEAR : GOAL_MAX;
+    solver.nodeLimit = nodeLimit;
+
+    auto start = std::chrono::steady_clock::now();
+    solver.solve();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (solver.goal == GOAL_CLEAR)
+        std::cout << (solver.solved ? "Solved, every layer cleared:" : "No solution found") << std::endl;
+    else
+        std::cout << "Best: " << solver.bestCleared << " layers cleared with " << solver.bestPath.size() << " pieces:" << std::endl;
+
+    if (solver.solved || solver.goal == GOAL_MAX)
+        for (int i = 0; i < (int) solver.bestPath.size(); i++)
+        {
+            const Placement &placement = solver.bestPath[i];
+            std::cout << "    piece " << i << " (shape " << puzzle.shapes[i] << "): orientation " << placement.orientation
+                      << " at " << placement.offset.x << " " << placement.offset.y << " " << placement.offset.z << std::endl;
+        }
+
+    long long nodes = solver.nodes;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Nodes: " << nodes << " in " << seconds << " s (" << nodes / seconds << " nodes/s)"
+              << (nodeLimit > 0 && nodes >= nodeLimit ? ", node limit reached" : "") << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads that split index ranges between them; the calling thread works along
+class ThreadPool
+{
+    public:
+        ThreadPool(int threads = std::thread::hardware_concurrency());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        int getThreadCount() const { return (int) workers.size() + 1; }
+
+        // Call task(index, thread) for every index in [0, n) and wait until all calls returned.
+        // thread is in [0, getThreadCount()), so tasks can keep per-thread scratch data without locking
+        void parallelFor(int n, const std::function<void(int index, int thread)> &task);
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+
+        const std::function<void(int, int)> *task = nullptr;
+        int taskSize = 0;
+        std::atomic<int> nextIndex{0};
+        int generation = 0; // incremented for every parallelFor(), so workers notice new work
+        int busyWorkers = 0;
+        bool stopping = false;
+
+        void runWorker(int thread);
+        void runTask(int thread);
+};
+
+ThreadPool::ThreadPool(int threads)
+{
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(&ThreadPool::runWorker, this, t);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int, int)> &task)
+{
+    // Not worth waking anyone up
+    if (workers.empty() || n <= 1)
+    {
+        for (int i = 0; i < n; i++)
+            task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        taskSize = n;
+        nextIndex = 0;
+        busyWorkers = (int) workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runTask(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+    this->task = nullptr;
+}
+
+void ThreadPool::runWorker(int thread)
+{
+    int seenGeneration = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runTask(thread);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0)
+            done.notify_one();
+    }
+}
+
+void ThreadPool::runTask(int thread)
+{
+    for (int i = nextIndex++; i < taskSize; i = nextIndex++)
+        (*task)(i, thread);
+}
+
+#endif
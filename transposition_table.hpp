@@ -0,0 +1,84 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+
+
+// Fixed-size cache of search results keyed by Zobrist hash, shared by search threads without locks.
+// Each slot keeps (key ^ data) next to data, so a slot torn by two simultaneous stores reads as a miss instead of a wrong result.
+// Colliding keys simply replace each other.
+class TranspositionTable
+{
+    public:
+        struct Entry
+        {
+            float value;
+            int depth; // how far ahead value was searched (0 for a static evaluation), in [0, 2^31)
+        };
+
+        TranspositionTable(int sizeLog2 = 20);
+
+        bool probe(uint64_t key, Entry &entry) const;
+        void store(uint64_t key, Entry entry); // keeps an entry of the same key searched deeper
+        void clear(); // not safe while other threads use the table
+
+        size_t getSize() const { return mask + 1; }
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> check{0}; // key ^ data
+            std::atomic<uint64_t> data{0};
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        uint64_t mask;
+
+        static const uint64_t VALID = 1ull << 63; // distinguishes stored entries from empty slots
+
+        static uint64_t pack(Entry entry) { return VALID | (uint64_t) (uint32_t) entry.depth << 32 | std::bit_cast<uint32_t>(entry.value); }
+        static Entry unpack(uint64_t data) { return { std::bit_cast<float>((uint32_t) data), (int) ((data >> 32) & 0x7FFFFFFF) }; }
+};
+
+TranspositionTable::TranspositionTable(int sizeLog2) : slots(new Slot[1ull << sizeLog2]), mask((1ull << sizeLog2) - 1)
+{
+}
+
+bool TranspositionTable::probe(uint64_t key, Entry &entry) const
+{
+    const Slot &slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if (!(data & VALID) || (check ^ data) != key)
+        return false;
+
+    entry = unpack(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, Entry entry)
+{
+    Slot &slot = slots[key & mask];
+
+    Entry stored;
+    if (probe(key, stored) && stored.depth > entry.depth)
+        return;
+
+    uint64_t data = pack(entry);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+    slot.data.store(data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear()
+{
+    for (uint64_t i = 0; i <= mask; i++)
+    {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif
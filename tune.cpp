@@ -0,0 +1,211 @@
+// Tunes the Bot's evaluation weights with the cross-entropy method: every generation samples a population of
+// weight vectors around the current mean, plays the same fixed set of seeded games with each one (in parallel),
+// and moves the mean and deviation to the best quarter. Progress is checkpointed, so a run can be stopped and resumed
+//
+// usage: tune [checkpoint file] [generations] [population] [games per candidate] [max pieces per game] [threads]
+
+#include "game_core.hpp"
+#include "evaluation.hpp"
+#include "bot.hpp"
+#include "piece_source.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+#define WEIGHT_COUNT 5
+
+void toArray(const BotWeights &weights, double *values)
+{
+    values[0] = weights.holes;
+    values[1] = weights.aggregateHeight;
+    values[2] = weights.layerCompleteness;
+    values[3] = weights.wellDepth;
+    values[4] = weights.coveredCells;
+}
+
+BotWeights fromArray(const double *values)
+{
+    BotWeights weights;
+    weights.holes = values[0];
+    weights.aggregateHeight = values[1];
+    weights.layerCompleteness = values[2];
+    weights.wellDepth = values[3];
+    weights.coveredCells = values[4];
+    return weights;
+}
+
+struct Checkpoint
+{
+    int generation = 0;
+    double mean[WEIGHT_COUNT];
+    double deviation[WEIGHT_COUNT];
+    double bestFitness = -1.0;
+    double best[WEIGHT_COUNT];
+};
+
+// Written to a temporary file first, so an interrupted write never destroys the previous checkpoint
+bool saveCheckpoint(const std::string &path, const Checkpoint &checkpoint)
+{
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        file << std::setprecision(17);
+        file << "generation " << checkpoint.generation << "\nmean";
+        for (double value : checkpoint.mean) file << " " << value;
+        file << "\ndeviation";
+        for (double value : checkpoint.deviation) file << " " << value;
+        file << "\nbest " << checkpoint.bestFitness;
+        for (double value : checkpoint.best) file << " " << value;
+        file << "\n";
+        if (!file)
+            return false;
+    }
+
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool loadCheckpoint(const std::string &path, Checkpoint &checkpoint)
+{
+    std::ifstream file(path);
+    std::string label;
+    file >> label >> checkpoint.generation >> label;
+    for (double &value : checkpoint.mean) file >> value;
+    file >> label;
+    for (double &value : checkpoint.deviation) file >> value;
+    file >> label >> checkpoint.bestFitness;
+    for (double &value : checkpoint.best) file >> value;
+
+    return (bool) file;
+}
+
+// Layers cleared in a game where every piece goes where the Bot without lookahead would put it;
+// planner is the scratch memory of one pool thread, reused for every game it plays
+int playGame(const BotWeights &weights, uint64_t seed, int maxPieces, GreedyPlanner &planner)
+{
+    GameState state;
+    state.pieces.reset(seed);
+    state.spawn();
+
+    int rowsCleared = 0;
+    for (int piece = 0; piece < maxPieces && state.state == ACTIVE; piece++)
+    {
+        Placement best = planner.choose(state.getArea(), state.player, weights);
+        if (best.orientation < 0)
+            break;
+
+        rowsCleared += state.place(best.orientation, best.offset);
+    }
+
+    return rowsCleared;
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "tune.checkpoint";
+    int generations = argc > 2 ? std::stoi(argv[2]) : 50;
+    int population = argc > 3 ? std::stoi(argv[3]) : 32;
+    int games = argc > 4 ? std::stoi(argv[4]) : 16;
+    int maxPieces = argc > 5 ? std::stoi(argv[5]) : 1000;
+    int threads = argc > 6 ? std::stoi(argv[6]) : std::max(1u, std::thread::hardware_concurrency());
+    if (generations < 1 || population < 4 || games < 1 || maxPieces < 1 || threads < 1)
+    {
+        std::cout << "usage: tune [checkpoint file] [generations] [population >= 4] [games per candidate] [max pieces per game] [threads]" << std::endl;
+        return 1;
+    }
+    const int elite = population / 4;
+
+    Checkpoint checkpoint;
+    if (loadCheckpoint(path, checkpoint))
+        std::cout << "Resuming from " << path << " at generation " << checkpoint.generation << std::endl;
+    else
+    {
+        toArray(BotWeights(), checkpoint.mean);
+        for (int w = 0; w < WEIGHT_COUNT; w++)
+            checkpoint.deviation[w] = std::max(1.0, std::abs(checkpoint.mean[w]) / 2);
+        toArray(BotWeights(), checkpoint.best);
+    }
+
+    ThreadPool pool(threads);
+    std::vector<GreedyPlanner> planners(pool.getThreadCount());
+    std::vector<double> candidates(population * WEIGHT_COUNT);
+    std::vector<int> rows(population * games);
+    std::vector<double> fitness(population);
+    std::vector<int> order(population);
+
+    std::cout << std::fixed << std::setprecision(3);
+    while (checkpoint.generation < generations)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        // Seeded by generation, so a resumed run samples the same candidates
+        Random random(checkpoint.generation);
+        for (int c = 0; c < population; c++)
+            for (int w = 0; w < WEIGHT_COUNT; w++)
+            {
+                // Box-Muller
+                double u = 1.0 - random.nextDouble(), v = random.nextDouble();
+                double normal = std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * M_PI * v);
+                candidates[c * WEIGHT_COUNT + w] = checkpoint.mean[w] + checkpoint.deviation[w] * normal;
+            }
+
+        // Every candidate plays the same seeds; each (candidate, game) pair is an independent task
+        pool.parallelFor(population * games, [&](int i, int thread) {
+            int c = i / games;
+            rows[i] = playGame(fromArray(&candidates[c * WEIGHT_COUNT]), i % games + 1, maxPieces, planners[thread]);
+        });
+
+        for (int c = 0; c < population; c++)
+        {
+            fitness[c] = 0.0;
+            for (int g = 0; g < games; g++)
+                fitness[c] += rows[c * games + g];
+            fitness[c] /= games;
+            order[c] = c;
+        }
+        std::sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] > fitness[b]; });
+
+        // Fit the distribution to the elite
+        for (int w = 0; w < WEIGHT_COUNT; w++)
+        {
+            double mean = 0.0, variance = 0.0;
+            for (int e = 0; e < elite; e++)
+                mean += candidates[order[e] * WEIGHT_COUNT + w];
+            mean /= elite;
+            for (int e = 0; e < elite; e++)
+                variance += std::pow(candidates[order[e] * WEIGHT_COUNT + w] - mean, 2);
+            checkpoint.mean[w] = mean;
+            checkpoint.deviation[w] = std::sqrt(variance / elite) + 0.01; // a little noise keeps it from collapsing early
+        }
+
+        if (fitness[order[0]] > checkpoint.bestFitness)
+        {
+            checkpoint.bestFitness = fitness[order[0]];
+            std::copy(&candidates[order[0] * WEIGHT_COUNT], &candidates[order[0] * WEIGHT_COUNT] + WEIGHT_COUNT, checkpoint.best);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generation " << checkpoint.generation << "\tbest " << fitness[order[0]] << "\tmedian " << fitness[order[population / 2]]
+                  << "\tall-time best " << checkpoint.bestFitness << "\t(" << population * games / seconds << " games/s)" << std::endl;
+
+        checkpoint.generation++;
+        if (!saveCheckpoint(path, checkpoint))
+            std::cout << "Failed to write checkpoint " << path << std::endl;
+    }
+
+    const char *names[WEIGHT_COUNT] = { "holes", "aggregateHeight", "layerCompleteness", "wellDepth", "coveredCells" };
+    std::cout << "Best weights (" << checkpoint.bestFitness << " layers per game):" << std::endl;
+    for (int w = 0; w < WEIGHT_COUNT; w++)
+        std::cout << "    " << names[w] << " = " << checkpoint.best[w] << std::endl;
+
+    return 0;
+}
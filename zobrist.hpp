@@ -0,0 +1,28 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+
+// Zobrist keys for hashing game states; keys are computed on the fly from their index, so there are no tables to share
+
+// splitmix64 finalizer, turns consecutive indices into unrelated 64-bit values
+constexpr uint64_t mixHash(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Key of an occupied cell within a layer (bit as in LayerMask)
+constexpr uint64_t getCellKey(int bit) { return mixHash(bit); }
+
+// Contribution of a layer with the given occupancy hash at height y; empty layers contribute nothing,
+// so an empty Area hashes to 0 and layers can move (when clearing) without rehashing their cells
+constexpr uint64_t getLayerKey(uint64_t layerHash, int y) { return layerHash ? mixHash(layerHash ^ mixHash(~(uint64_t) y)) : 0; }
+
+// Key of the active piece
+constexpr uint64_t getPieceKey(int shapeIndex, int orientation) { return mixHash(1ull << 40 | (uint64_t) shapeIndex << 8 | (uint64_t) orientation); }
+
+#endif